@@ -1,292 +1,282 @@
-#include <limits>
+#include "lattice.hpp"
+#include "storedTree.hpp"
+
+#include <map>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
 #include <vector>
 #include <iostream>
-#include <exception>
 
-constexpr char INDUCED_VERTEX = 'X', EMPTY_VERTEX = '_';
+// Number of trees read before they are validated in parallel in stream mode.
+constexpr unsigned BATCH_SIZE = 1 << 14;
 
-class CubicLattice
+// The results of validating one tree.
+struct analysis
+{
+	unsigned numInduced;
+	bool connected, validNeighbors, enclosedSpace, tree;
+	unsigned numFaces;
+};
+
+// Validates a tree. The buffers are reused between calls.
+class analyzer
 {
-	enum vertexLabel
-	{
-		induced,
-		inducedConnected,
-		empty,
-		emptyConnected,
-		disabled
-	};
-	
-	struct vertex
-	{
-		vertexLabel label;
-		unsigned char degree, numNeighbors;
-		std::vector<unsigned> adjList;
-		
-		vertex() : label(empty), degree(0) {}
-	};
-	
-	constexpr static unsigned EMPTY = std::numeric_limits<unsigned>::max();
-	
-	// Dims for the length of each axis, and the size of a cross section
-	// up to a given dimension.
-	std::vector<unsigned> dims, dimSizes;
-	std::vector<vertex> graph;
-	
-	unsigned _numInduced;
-	
-	// Extracts the d-dimension coordinate from an index.
-	unsigned get_coord(unsigned d, unsigned index) const
-	{
-		return (index / dimSizes[d]) % dims[d];
-	}
-	
-	// Starting at the current vertex (graph[index]), finds the first vertex with
-	// a given label and stores that into index. Returns true if a vertex
-	// with the given label was found, and false if not (and index = graph.size()))
-	bool getFirstWithLabel(unsigned& index, vertexLabel label) const
-	{
-		for (; index < graph.size(); index++)
-			if (graph[index].label == label)
-				return true;
-		return false;
-	}
-	
-	// Returns true iff the label represents a selected block.
-	static bool exists(vertexLabel label)
-	{
-		return label == inducedConnected || label == induced;
-	}
-	
-	unsigned forward(unsigned d, unsigned index) const
-	{
-		return (get_coord(d,index) == dims[d] - 1) ? EMPTY : index + dimSizes[d];
-	}
-	
-	unsigned backward(unsigned d, unsigned index) const
-	{
-		return (get_coord(d,index) == 0) ? EMPTY : index - dimSizes[d];
-	}
-		
-	// Uses a depth-first-search to mark all connected vertices
-	// in the graph with a given label with a new label.
-	void mark_connected(unsigned index, vertexLabel oldLabel, vertexLabel newLabel)
-	{
-		if (graph[index].label == oldLabel)
-		{
-			graph[index].label = newLabel;
-			
-			for (unsigned i : graph[index].adjList)
-			{
-				if (i != EMPTY)
-				{
-					mark_connected(i, oldLabel, newLabel);
-				}
-			}
-		}
-	}
-	
 	public:
 	
-	// Constructs a cubic lattice of side length s, and sets
-	// all vertices to empty.
-	CubicLattice(const std::vector<unsigned>& ds) : dims(ds),
-		dimSizes(ds.size() + 1), _numInduced(0)
+	analysis operator()(const Lattice& L, const StoredTree& t)
 	{
-		dimSizes[0] = 1;
-		for (unsigned i = 0; i < dims.size(); ++i)
-		{
-			dimSizes[i + 1] = dimSizes[i] * dims[i];
-		}
+		induced.assign(t.induced.begin(), t.induced.end());
 		
-		graph.resize(dimSizes.back());
+		analysis result;
+		result.numInduced     = t.numInduced;
+		result.connected      = isConnected(L);
+		result.validNeighbors = validateNeighbors(L);
 		
-		for (unsigned i = 0; i < graph.size(); ++i)
+		L.reachFromShell(induced, reached);
+		
+		result.enclosedSpace = false;
+		for (unsigned v = 0; v < L.numVertices(); ++v)
 		{
-			auto& adjList = graph[i].adjList;
-			
-			adjList.resize(2 * dims.size());
-			
-			// The highest dimension has the largest and smallest neighbors.
-			// The second highest dimension has the second largest
-			// and second smallest neighbors, etc.
-			// Neighbors on the same axis are on 'mirror' indexes.
-			for (unsigned d = 0; d < dims.size(); ++d)
-			{
-				adjList[dims.size() - d - 1] = backward(d,i);
-				adjList[dims.size() + d    ] = forward (d,i);
-			}
-			
-			graph[i].numNeighbors = std::count_if(adjList.begin(), adjList.end(),
-				[](unsigned adj)
-				{
-					return adj != EMPTY;
-				}
-			);
+			if (!induced[v] && !reached[v]) result.enclosedSpace = true;
 		}
-	}
-	
-	// Adds an induced vertex at a given index
-	void add(unsigned index)
-	{
-		graph[index].label = induced;
 		
-		++_numInduced;
+		result.numFaces = numFaces(L);
 		
-		for (unsigned i : graph[index].adjList)
-		{
-			if (i != EMPTY)
-			{
-				++graph[i].degree;
-			}
-		}
+		// Every vertex has 2d faces, and each edge of a tree hides two.
+		result.tree = result.connected && result.numFaces ==
+			(L.numDirections() - 2) * result.numInduced + 2;
+		
+		return result;
 	}
 	
-	// Returns the number of vertices in the graph.
-	unsigned numVertices() const
-	{
-		return dimSizes.back();
-	}
+	private:
 	
-	// Returns the number of induced vertices in the graph.
-	unsigned numInduced() const
-	{
-		return _numInduced;
-	}
+	std::vector<char> induced, reached, visited;
+	std::vector<unsigned> stack;
 	
-	bool isConnected()
+	// Iterative depth-first search from the first induced vertex.
+	bool isConnected(const Lattice& L)
 	{
-		unsigned index = 0;
+		visited.assign(L.numVertices(), false);
 		
-		// This will return false when the graph is empty, we say that
-		// an empty graph is connected.
-		if(!getFirstWithLabel(index,induced))
-			return true;
+		unsigned start = 0;
+		while (start < L.numVertices() && !induced[start]) ++start;
 		
-		mark_connected(index,induced,inducedConnected);
+		// We say that an empty graph is connected.
+		if (start == L.numVertices()) return true;
 		
-		// There should no longer be any vertices with the 'induced' label.
-		return !getFirstWithLabel(index,induced);
-	}
-	
-	// Returns true iff all induced vertices have no more than three
-	// neighbors in a given plane.
-	bool validateNeighbors() const
-	{
-		for (unsigned i = 0; i < graph.size(); i++)
+		unsigned numVisited = 1;
+		visited[start] = true;
+		stack.push_back(start);
+		
+		while (!stack.empty())
 		{
-			if (exists(graph[i].label))
+			unsigned v = stack.back();
+			stack.pop_back();
+			
+			for (unsigned dir = 0; dir < L.numDirections(); ++dir)
 			{
-				// Ensure there is at most one axis with 2 neighbors
-				bool hasAxisWith2Neighbors = false;
-				for (unsigned d = 0; d < dims.size(); ++d)
+				unsigned y = L.neighbor(v,dir);
+				if (y != Lattice::EMPTY && induced[y] && !visited[y])
 				{
-					unsigned adj1 = graph[i].adjList[d];
-					unsigned adj2 = graph[i].adjList[graph[i].adjList.size() - d - 1];
-					if (adj1 != EMPTY && exists(graph[adj1].label)
-					 && adj2 != EMPTY && exists(graph[adj2].label))
-					{
-						if (hasAxisWith2Neighbors) return false;
-						hasAxisWith2Neighbors = true;
-					}
+					visited[y] = true;
+					++numVisited;
+					stack.push_back(y);
 				}
 			}
 		}
-		return true;
+		
+		unsigned numInduced = 0;
+		for (char i : induced) numInduced += i;
+		
+		return numVisited == numInduced;
 	}
 	
-	// Returns true iff there are block(s) whose faces cannot be
-	// accessed externally.
-	bool hasEnclosedSpace()
+	// Returns true iff all induced vertices have at most one axis with both neighbors.
+	bool validateNeighbors(const Lattice& L) const
 	{
-		// This could be made slightly faster by only looking
-		// at each 'face' of the graph, but that would be
-		// a much more complicated implementation. Either way,
-		// the algorithm is still O(nv).
-		for (unsigned i = 0; i < graph.size(); i++)
+		for (unsigned v = 0; v < L.numVertices(); ++v)
 		{
-			// Initialize a search in all vertices that are missing neighbors, i.e.
-			// neighbors on the outer shell of the graph.
-			if (graph[i].numNeighbors != (2 * dims.size()))
-			{
-				mark_connected(i, empty, emptyConnected);
-			}
+			if (induced[v] && !L.validate(induced,v)) return false;
 		}
-		
-		// getFirstWithLabel needs a reference to a variable
-		unsigned index = 0;
-		return getFirstWithLabel(index, empty);
+		return true;
 	}
 	
-	// Assumes that isConnected() has been called and returned true,
-	// and hasEnclosedSpace() has been called.
-	unsigned numFaces() const
+	// Counts the faces of induced vertices that can be accessed externally.
+	unsigned numFaces(const Lattice& L) const
 	{
 		unsigned sum = 0;
 		
-		for (unsigned i = 0; i < graph.size(); i++)
+		for (unsigned v = 0; v < L.numVertices(); ++v)
 		{
-			switch (graph[i].label)
+			unsigned degree = 0;
+			for (unsigned dir = 0; dir < L.numDirections(); ++dir)
 			{
-				case inducedConnected: sum += (6 - graph[i].degree); break;
-				case empty:            sum -= graph[i].degree; break;
+				unsigned y = L.neighbor(v,dir);
+				degree += (y != Lattice::EMPTY && induced[y]);
 			}
+			
+			if (induced[v])      sum += L.numDirections() - degree;
+			else if (!reached[v]) sum -= degree;
 		}
 		return sum;
 	}
 };
 
-void readSizes(std::istream& stream, std::vector<unsigned>& result)
+// Reads one tree from stdin and prints a full report.
+int analyzeOne()
 {
-	for (int c; (c = stream.peek()) != '\n' && stream;)
+	StoredTree t;
+	if (!t.read(std::cin))
 	{
-		if ('0' <= c && c <= '9')
-		{
-			unsigned& value = result.emplace_back();
-			stream >> value;
-		}
-		else stream.ignore();
+		std::cerr << "error reading input, are there enough vertices?\n";
+		return 1;
 	}
+	
+	Lattice L(t.dims);
+	analysis result = analyzer()(L,t);
+	
+	std::cout << std::boolalpha;
+	
+	std::cout << result.numInduced << " induced vertices" << std::endl;
+	
+	std::cout << "Graph is connected: "
+		<< result.connected << std::endl;
+	
+	std::cout << "Graph satisfies neighbor condition: "
+		<< result.validNeighbors << std::endl;
+	
+	std::cout << "Graph has enclosed space: "
+		<< result.enclosedSpace << std::endl;
+	
+	std::cout << "Number of faces: " << result.numFaces << std::endl;
+	
+	std::cout << "Graph is a tree: "
+		<< result.tree << std::endl;
+	
+	return 0;
 }
 
-int main()
+// Reads trees from stdin until the end of the input and validates them in
+// parallel, printing any that are not valid trees without enclosed space.
+int analyzeStream(bool binary)
 {
-	std::vector<unsigned> sizes;
-	readSizes(std::cin, sizes);
+	const unsigned numThreads = std::max(1u, std::thread::hardware_concurrency());
+	
+	std::vector<analyzer> analyzers(numThreads);
+	
+	// Lattices are shared between all trees with the same dimensions.
+	std::map<std::vector<unsigned>, std::unique_ptr<Lattice>> lattices;
 	
-	CubicLattice graph(sizes);
+	std::vector<StoredTree> batch(BATCH_SIZE);
+	std::vector<const Lattice*> batchLattices(BATCH_SIZE);
+	std::vector<analysis> results(BATCH_SIZE);
 	
-	char symbol;
-	for (unsigned i = 0; i < graph.numVertices(); ++i)
+	uintmax_t numTrees = 0, numValid = 0, notConnected = 0,
+		invalidNeighbors = 0, enclosed = 0, notTree = 0;
+	
+	auto start = std::chrono::steady_clock::now();
+	
+	while (true)
 	{
-		if (!(std::cin >> symbol))
+		unsigned size = 0;
+		while (size < BATCH_SIZE && (binary ? batch[size].readBinary(std::cin)
+		                                    : batch[size].read(std::cin)))
 		{
-			std::cerr << "error reading input, are there enough vertices?\n";
-			return 1;
+			auto& L = lattices[batch[size].dims];
+			if (!L) L = std::make_unique<Lattice>(batch[size].dims);
+			batchLattices[size] = L.get();
+			++size;
 		}
 		
-		if (symbol == INDUCED_VERTEX)
+		if (size == 0) break;
+		
+		
+		std::vector<std::thread> threads;
+		for (unsigned id = 0; id < numThreads; ++id)
 		{
-			graph.add(i);
+			threads.emplace_back([&, id]()
+			{
+				for (unsigned i = id; i < size; i += numThreads)
+				{
+					results[i] = analyzers[id](*batchLattices[i], batch[i]);
+				}
+			});
+		}
+		for (auto& t : threads) t.join();
+		
+		for (unsigned i = 0; i < size; ++i, ++numTrees)
+		{
+			const analysis& r = results[i];
+			
+			notConnected     += !r.connected;
+			invalidNeighbors += !r.validNeighbors;
+			enclosed         +=  r.enclosedSpace;
+			notTree          += !r.tree;
+			
+			if (r.connected && r.validNeighbors && !r.enclosedSpace && r.tree)
+			{
+				++numValid;
+				continue;
+			}
+			
+			std::cout << "Tree " << numTrees << " (" << r.numInduced << " vertices):"
+				<< (r.connected      ? "" : " not connected")
+				<< (r.validNeighbors ? "" : " breaks neighbor condition")
+				<< (r.enclosedSpace  ? " has enclosed space" : "")
+				<< (r.tree           ? "" : " not a tree") << std::endl;
 		}
 	}
 	
-	std::cout << std::boolalpha;
+	if (!std::cin.eof())
+	{
+		std::cerr << "error reading tree " << numTrees << std::endl;
+		return 1;
+	}
 	
-	unsigned numVert = graph.numInduced();
-	std::cout << numVert << " induced vertices" << std::endl;
+	double seconds = std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - start).count();
 	
-	std::cout << "Graph is connected: "
-		<< graph.isConnected() << std::endl;
+	std::cout << numTrees << " trees read, " << numValid << " valid, "
+		<< notConnected << " not connected, " << invalidNeighbors
+		<< " breaking the neighbor condition, " << enclosed << " with enclosed space, "
+		<< notTree << " not trees, " << numTrees / seconds << " trees/second" << std::endl;
 	
-	std::cout << "Graph satisfies neighbor condition: "
-		<< graph.validateNeighbors() << std::endl;
+	return numTrees == numValid ? 0 : 2;
+}
+
+// Converts trees from the text format on stdin to the binary format on
+// stdout, for later runs of analyzeStream(true).
+int toBinary()
+{
+	StoredTree t;
+	while (t.read(std::cin)) t.writeBinary(std::cout);
 	
-	std::cout << "Graph has enclosed space: "
-		<< graph.hasEnclosedSpace() << std::endl;
+	if (!std::cin.eof())
+	{
+		std::cerr << "error reading a tree" << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+int main(int num_args, char** args)
+{
+	std::vector<std::string> options(args + 1, args + num_args);
 	
-	unsigned numFaces = graph.numFaces();
-	std::cout << "Number of faces: " << numFaces << std::endl;
+	if (options.empty()) return analyzeOne();
 	
-	std::cout << "Graph is a tree: "
-		<< (numFaces == 4 * numVert + 2) << std::endl;
+	if (options == std::vector<std::string>{ "--stream" })
+		return analyzeStream(false);
+	
+	if (options == std::vector<std::string>{ "--stream", "--binary" })
+		return analyzeStream(true);
+	
+	if (options == std::vector<std::string>{ "--to-binary" })
+		return toBinary();
+	
+	std::cerr << "usage: " << args[0] << " [--stream [--binary] | --to-binary] < <file>" << std::endl;
+	return 1;
 }
@@ -0,0 +1,166 @@
+#include "defs.hpp"
+#include "graph.hpp"
+#include "subTree.hpp"
+#include "playout.hpp"
+#include "indexedList.hpp"
+
+#include <bitset>
+#include <vector>
+#include <future>
+#include <random>
+#include <iostream>
+#include <algorithm>
+#include <unordered_set>
+
+// Beam search over trees containing vertex 0. Each step expands every tree in
+// the beam by every valid vertex, scores each child by the size of the best
+// of a few random playouts from it, and keeps the best distinct children.
+
+struct beamState
+{
+	Subtree S;
+	indexedList<Graph::vertexID, Graph::numVertices> border;
+	
+	beamState() : S(0)
+	{
+		defs::simpleUpdate(S,border,0);
+	}
+};
+
+// Seeded separately for each thread, so parallel playouts differ.
+thread_local std::mt19937 rng(std::random_device{}());
+
+// Playouts choose uniformly among the vertices that can be added.
+const playoutPolicy policy;
+
+// A child of a tree in the beam, which is only built if it is kept.
+struct candidate
+{
+	unsigned parent;
+	Graph::vertexID x;
+	unsigned score;
+};
+
+// Scores the children of beam[first, last) and appends them to result.
+void expand(int id, std::vector<beamState>& beam, unsigned first, unsigned last,
+	unsigned rollouts, std::vector<candidate>& result)
+{
+	for (unsigned i = first; i < last && !defs::stopRequested; ++i)
+	{
+		auto& [S, border] = beam[i];
+		
+		defs::pruneBorder(S,border);
+		
+		for (Graph::vertexID x : border)
+		{
+			Subtree child = S;
+			indexedList<Graph::vertexID, Graph::numVertices> childBorder = border;
+			
+			child.add(x);
+			childBorder.remove(x);
+			defs::simpleUpdate(child,childBorder,x);
+			
+			unsigned score = child.numInduced;
+			for (unsigned r = 0; r < rollouts; ++r)
+			{
+				Subtree T = child;
+				noPath path;
+				score = std::max(score, playout(id,T,childBorder,policy,rng,path));
+			}
+			
+			result.push_back({i,x,score});
+		}
+	}
+}
+
+int main(int num_args, char** args)
+{
+	if (num_args < 2 || num_args > 4)
+	{
+		std::cerr << "usage: " << args[0] << " <outfile> [width] [rollouts]" << std::endl;
+		exit(1);
+	}
+	
+	defs::outfile = args[1];
+	
+	unsigned width    = (num_args >= 3) ? std::stoi(args[2]) : 256;
+	unsigned rollouts = (num_args >= 4) ? std::stoi(args[3]) : 4;
+	
+	defs::start_time = clock();
+	
+	defs::installSignalHandlers();
+	
+	if (defs::seedFromCache())
+	{
+		std::clog << "Largest size (no enclosed space) = " << defs::largestTree
+			<< " (already known)" << std::endl;
+		return 0;
+	}
+	
+	std::vector<beamState> beam(1);
+	
+	for (unsigned depth = 1; !defs::stopRequested; ++depth)
+	{
+		// Split the beam evenly between the threads.
+		unsigned chunks = std::min<unsigned>(defs::NUM_THREADS, beam.size());
+		std::vector<std::vector<candidate>> results(chunks);
+		std::vector<std::future<void>> done;
+		for (unsigned c = 0; c < chunks; ++c)
+		{
+			done.push_back(defs::pool.push(expand, std::ref(beam),
+				c * beam.size() / chunks, (c + 1) * beam.size() / chunks,
+				rollouts, std::ref(results[c])));
+		}
+		for (auto& f : done) defs::waitFor(f);
+		
+		std::vector<candidate> children;
+		for (auto& r : results) children.insert(children.end(), r.begin(), r.end());
+		
+		if (children.empty()) break;
+		
+		std::stable_sort(children.begin(), children.end(),
+			[](const candidate& a, const candidate& b) { return a.score > b.score; });
+		
+		// Keep the best children, skipping any tree already in the next beam.
+		std::vector<beamState> next;
+		std::unordered_set<std::bitset<Graph::numVertices>> seen;
+		for (const candidate& c : children)
+		{
+			if (next.size() == width) break;
+			
+			std::bitset<Graph::numVertices> key;
+			for (Graph::vertexID x = 0; x < Graph::numVertices; ++x)
+			{
+				key[x] = beam[c.parent].S.has(x);
+			}
+			key[c.x] = true;
+			
+			if (!seen.insert(key).second) continue;
+			
+			beamState& child = next.emplace_back(beam[c.parent]);
+			child.S.add(c.x);
+			child.border.remove(c.x);
+			defs::simpleUpdate(child.S,child.border,c.x);
+		}
+		
+		uintmax_t total = 0;
+		for (uintmax_t n : defs::numLeaves) total += n;
+		
+		{
+			std::lock_guard<std::mutex> lock(defs::IOmutex);
+			
+			std::cout << "Depth " << depth << ": " << next.size() << " trees kept of "
+				<< children.size() << ", best score = " << children.front().score << ", "
+				<< total / defs::threadSeconds() << " playouts/thread-second" << std::endl;
+			
+			defs::lastWasNew = false;
+		}
+		
+		std::swap(beam, next);
+	}
+	
+	std::clog << "Largest size (no enclosed space) = " << defs::largestTree
+		<< (defs::stopRequested ? " (stopped early)" : "") << std::endl;
+	
+	defs::storeResult(false);
+}
@@ -1,60 +1,130 @@
 #include "defs.hpp"
+#include "resultsCache.hpp"
 
+#include <queue>
+#include <latch>
+#include <fstream>
 #include <iostream>
+#include <filesystem>
 
-void defs::update(const Subtree& S, indexedList<Graph::vertexID, Graph::numVertices>& border,
-	Graph::vertexID x, std::stack<action>& previous_actions)
+#ifdef __linux__
+#include <sched.h>
+#include <pthread.h>
+#endif
+
+float defs::threadSeconds()
 {
-	for (Graph::vertexID y : Graph::vertices[x].neighbors)
+	return (float)(clock()-start_time)/(CLOCKS_PER_SEC);
+}
+
+#ifdef __linux__
+// Returns the CPUs this process may run on, with those of each NUMA node
+// next to each other. Without NUMA, there are no nodes and the order is kept.
+static std::vector<int> cpusByNode()
+{
+	cpu_set_t allowed;
+	CPU_ZERO(&allowed);
+	sched_getaffinity(0, sizeof(allowed), &allowed);
+	
+	std::vector<int> result;
+	std::vector<bool> listed(CPU_SETSIZE, false);
+	
+	std::error_code error;
+	for (const auto& entry : std::filesystem::directory_iterator("/sys/devices/system/node", error))
 	{
-		// Pushes the current action, will need
-		// to do the opposite action to reverse.
-		if (S.cnt(y) > 1)
+		if (!entry.path().filename().string().starts_with("node")) continue;
+		
+		// Lists ranges such as 0-3,8-11.
+		std::ifstream file(entry.path() / "cpulist");
+		for (std::string range; std::getline(file, range, ',');)
 		{
-			// This is a fix for the base algorithm, it will
-			// not work without this.
-			if (border.remove(y))
+			int first = std::stoi(range), last = first;
+			if (size_t dash = range.find('-'); dash != std::string::npos) last = std::stoi(range.substr(dash + 1));
+			
+			for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu)
 			{
-				previous_actions.push({rem,y});
+				if (CPU_ISSET(cpu, &allowed) && !listed[cpu]) result.push_back(cpu);
+				listed[cpu] = true;
 			}
 		}
-		else if (y > S.root && !S.has(y))
-		{
-			border.push_front(y);
-			previous_actions.push({add,y});
-		}
 	}
+	
+	for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+	{
+		if (CPU_ISSET(cpu, &allowed) && !listed[cpu]) result.push_back(cpu);
+	}
+	return result;
 }
+#endif
 
-void defs::restore(indexedList<Graph::vertexID, Graph::numVertices>& border,
-	std::stack<action>& previous_actions)
+void defs::pinThreads()
 {
-	while (true)
+#ifdef __linux__
+	std::vector<int> cpus = cpusByNode();
+	
+	// Every task waits for all the others to start, so each thread runs one.
+	std::latch started(NUM_THREADS);
+	
+	std::vector<std::future<void>> done;
+	for (int i = 0; i < NUM_THREADS; ++i)
 	{
-		action act = previous_actions.top();
-		previous_actions.pop();
-		
-		switch (act.type)
+		done.push_back(pool.push([&](int id)
 		{
-			case add:
-				border.remove(act.v);
-				break;
-			case rem:
-				border.push_front(act.v);
-				break;
-			case stop:
-				return;
-		}
+			started.arrive_and_wait();
+			
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			CPU_SET(cpus[id % cpus.size()], &set);
+			pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+			
+			// Pages are placed on the node of the thread that first writes them.
+			lists[id] = std::make_unique<scratch>();
+		}));
 	}
+	
+	for (auto& f : done) f.get();
+	
+	std::clog << NUM_THREADS << " threads pinned to " << std::min<size_t>(NUM_THREADS, cpus.size())
+		<< " CPUs" << std::endl;
+#endif
 }
 
-float defs::threadSeconds()
+void defs::printStatus()
 {
-	return (float)(clock()-start_time)/(CLOCKS_PER_SEC);
+	statusRequested = false;
+	
+	std::lock_guard<std::mutex> lock(IOmutex);
+	
+	uintmax_t totalNodes = 0, totalLeaves = 0;
+	for (int id = 0; id < NUM_THREADS; ++id)
+	{
+		totalNodes += numNodes[id].n;
+		totalLeaves += numLeaves[id];
+	}
+	
+	std::clog << std::endl << threadSeconds() << " thread-seconds: largest size " << largestTree
+		<< " (" << largestWithEnclosed << " with enclosed space), " << totalNodes << " nodes, "
+		<< totalLeaves << " leaves" << std::endl;
+	
+	for (int id = 0; id < NUM_THREADS; ++id)
+	{
+		std::clog << "  thread " << id << ": " << numNodes[id].n << " nodes, "
+			<< numLeaves[id] << " leaves, depth " << numNodes[id].depth << std::endl;
+	}
+	
+	lastWasNew = true;
 }
 
 void defs::checkCandidate(const Subtree& S)
 {
+	if (numForced != 0)
+	{
+		unsigned numFound = 0;
+		for (Graph::vertexID x = 0; x < Graph::numVertices; ++x) numFound += forced[x] && S.has(x);
+		
+		if (numFound != numForced) return;
+	}
+	
 	std::lock_guard<std::mutex> lock(IOmutex);
 	
 	if (S.numInduced > largestTree)
@@ -81,6 +151,7 @@ void defs::checkCandidate(const Subtree& S)
 		else
 		{
 			largestTree = S.numInduced;
+			bestTree = S.toStored();
 			
 			if (largestWithEnclosed < defs::largestTree)
 				largestWithEnclosed = defs::largestTree;
@@ -92,3 +163,159 @@ void defs::checkCandidate(const Subtree& S)
 		}
 	}
 }
+
+std::optional<Subtree> defs::loadTree(const StoredTree& t)
+{
+	StoredTree embedded;
+	if (!t.embed({ Graph::dim_array.begin(), Graph::dim_array.end() }, embedded))
+		return std::nullopt;
+	
+	Graph::vertexID root = 0;
+	while (root < Graph::numVertices && !embedded.induced[Graph::position(root)]) ++root;
+	
+	if (root == Graph::numVertices) return std::nullopt;
+	
+	// Add vertices in breadth-first order, so each has exactly
+	// one induced neighbor when it is added.
+	Subtree S(root);
+	std::queue<Graph::vertexID> toBeVisited;
+	toBeVisited.push(root);
+	
+	while (!toBeVisited.empty())
+	{
+		Graph::vertexID x = toBeVisited.front();
+		toBeVisited.pop();
+		
+		for (Graph::vertexID y : Graph::vertices[x].neighbors)
+		{
+			if (!embedded.induced[Graph::position(y)] || S.has(y)) continue;
+			
+			// A second induced neighbor means there is a cycle.
+			if (S.cnt(y) != 1 || !S.add(y)) return std::nullopt;
+			
+			toBeVisited.push(y);
+		}
+	}
+	
+	if (S.numInduced != embedded.numInduced) return std::nullopt;
+	
+	return S;
+}
+
+bool defs::loadMask(const std::string& filename)
+{
+	std::ifstream file(filename);
+	
+	// The first line holds the dimensions, which must match the lattice.
+	std::vector<unsigned> dims;
+	file >> std::ws;
+	for (int c; (c = file.peek()) != '\n' && file;)
+	{
+		if ('0' <= c && c <= '9') file >> dims.emplace_back();
+		else file.ignore();
+	}
+	
+	if (!std::equal(dims.begin(), dims.end(), Graph::dim_array.begin(), Graph::dim_array.end()))
+		return false;
+	
+	for (Graph::vertexID i = 0; i < Graph::numVertices; ++i)
+	{
+		char symbol;
+		if (!(file >> symbol)) return false;
+		
+		Graph::vertexID x = Graph::vertexAt(i);
+		switch (symbol)
+		{
+			case 'X': forced[x] = true; ++numForced; break;
+			case '#': forbidden[x] = true; break;
+			case '_': break;
+			default: return false;
+		}
+	}
+	
+	masked = true;
+	return true;
+}
+
+bool defs::seedFromCache()
+{
+	std::vector<unsigned> dims(Graph::dim_array.begin(), Graph::dim_array.end());
+	
+	// Read once, since every slice takes a bound from the same entries.
+	const auto cached = resultsCache::entries();
+	
+	sliceBounds.resize(dims.back());
+	for (unsigned slice = 0; slice < dims.back(); ++slice)
+	{
+		std::vector<unsigned> rest(dims);
+		rest.back() -= slice;
+		sliceBounds[slice] = resultsCache::upperBound(rest, cached);
+	}
+	
+	// Bounds for the whole lattice still hold for any part of it,
+	// but its trees may not fit the mask.
+	if (masked) return false;
+	
+	auto seed = resultsCache::lowerBound(dims, cached);
+	
+	if (!seed) return false;
+	
+	largestTree = largestWithEnclosed = seed->numInduced;
+	bestTree = *seed;
+	seed->writeToFile(outfile);
+	
+	std::clog << largestTree << " vertices, from the results cache" << std::endl;
+	
+	return seed->exact;
+}
+
+bool defs::seedFromTree(const std::string& filename)
+{
+	StoredTree t;
+	std::optional<Subtree> S;
+	if (t.readFromFile(filename)) S = loadTree(t);
+	
+	if (!S || S->hasEnclosedSpace()) return false;
+	
+	unsigned numFound = 0;
+	for (Graph::vertexID x = 0; x < Graph::numVertices; ++x)
+	{
+		if (S->has(x) && forbidden[x]) return false;
+		numFound += S->has(x) && forced[x];
+	}
+	if (numFound != numForced) return false;
+	
+	if (S->numInduced <= largestTree) return true;
+	
+	largestTree = largestWithEnclosed = S->numInduced;
+	bestTree = S->toStored();
+	S->writeToFile(outfile);
+	
+	std::clog << largestTree << " vertices, from " << filename << std::endl;
+	
+	return true;
+}
+
+unsigned defs::rootBound(Graph::vertexID root)
+{
+	// The lowest slice of any vertex from the root on, which in row-major
+	// order is just the slice of the root.
+	unsigned slice = Graph::dim_array.back() - 1;
+	for (Graph::vertexID x = root; x < Graph::numVertices; ++x)
+	{
+		slice = std::min<unsigned>(slice, Graph::get_coord(Graph::dim_array.size() - 1, x));
+	}
+	
+	return sliceBounds[slice];
+}
+
+void defs::storeResult(bool exact)
+{
+	// The output file may hold a tree from an earlier run, so only
+	// the one in memory is trusted.
+	if (masked || bestTree.numInduced == 0) return;
+	
+	StoredTree best = bestTree;
+	best.exact = exact;
+	resultsCache::store(best);
+}
@@ -3,49 +3,114 @@
 
 #include "../CTPL/ctpl_stl.h"
 #include "graph.hpp"
+#include "signals.hpp"
 #include "subTree.hpp"
 #include "indexedList.hpp"
+#include "layeredList.hpp"
 
 #include <stack>
 #include <ctime>
 #include <mutex>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <optional>
 
 // This file contains basic type definitions along with headers for some functions
 // shared between different programs, and 'global' variables.
 
 namespace defs
 {
-	enum action_type { add, rem, stop };
-	struct action { action_type type; Graph::vertexID v; };
+	enum action_type : uint_least8_t { add, rem, stop };
+	struct action { action_type type; Graph::storedID v; };
 	
 	inline const int NUM_THREADS = std::thread::hardware_concurrency();
 	
-	// Thread pool
-	inline ctpl::thread_pool pool(NUM_THREADS);
-	
 	// Maximum size graph seen so far
 	inline unsigned largestTree = 0, largestWithEnclosed = 0;
 	
+	// The tree of size largestTree, found or seeded by this process.
+	// Guarded by IOmutex while searches run.
+	inline StoredTree bestTree {};
+	
 	// File to write the best graph seen so far to
 	inline std::string outfile {};
 	
 	// The start time of the program
 	inline clock_t start_time {};
 	
-	// Grid of indexedLists, used to store the border elements as they are removed,
-	// then swapped back to restore. A call to branch can find the list it should
-	// use by going to lists[id][S.numInduced].
-	inline std::vector<
-		std::array<indexedList<Graph::vertexID, Graph::numVertices>, Graph::numVertices>
-	> lists(NUM_THREADS);
+	using scratch = layeredList<Graph::vertexID, Graph::numVertices>;
+	
+	// One layeredList per thread, used to store the border elements as they are
+	// removed, then moved back to restore. A call to branch can find the layer
+	// it should use by going to layer S.numInduced of lists[id]. Each is its own
+	// allocation, so pinThreads can place it on the memory of its thread's node.
+	inline std::vector<std::unique_ptr<scratch>> lists = []
+	{
+		std::vector<std::unique_ptr<scratch>> result(NUM_THREADS);
+		for (auto& l : result) l = std::make_unique<scratch>();
+		return result;
+	}();
 	
 	// Used to store the number of leaves seen thus far
 	inline std::vector<uintmax_t> numLeaves(NUM_THREADS, 0);
+	
+	// Counters for one thread, on their own cache line.
+	struct alignas(64) threadCount
+	{
+		uintmax_t n = 0;
+		
+		// The size of the tree the thread is working on, if it tracks one.
+		unsigned depth = 0;
+	};
+	
+	// The number of search nodes each thread has visited.
+	inline std::vector<threadCount> numNodes(NUM_THREADS);
+	
+	// If set, searches never add a vertex that encloses space, and
+	// so never see a tree with enclosed space.
+	inline bool pruneEnclosed = false;
+	
+	// Set by loadMask. Searches never add a forbidden vertex, and only
+	// report trees that contain every forced one.
+	inline std::array<bool, Graph::numVertices> forbidden {}, forced {};
+	inline unsigned numForced = 0;
+	inline bool masked = false;
+	
 	inline bool lastWasNew = false;
 	
+	// See signals.hpp.
+	using signals::statusRequested;
+	using signals::stopRequested;
+	using signals::installSignalHandlers;
+	
+	// Pins each thread of the pool to its own CPU, filling one NUMA node
+	// before the next, then has each thread allocate its own lists, so the
+	// pages come from its node. Does nothing outside Linux.
+	void pinThreads();
+	
+	// Prints the node and leaf counts, the largest tree and the depth of
+	// each thread, then clears statusRequested.
+	void printStatus();
+	
+	// Waits for a task, printing a status report whenever one is requested.
+	template<class T>
+	void waitFor(std::future<T>& task)
+	{
+		while (task.wait_for(std::chrono::milliseconds(100)) != std::future_status::ready)
+		{
+			if (statusRequested) printStatus();
+		}
+	}
+	
 	// Used for thread safety on any IO actions.
 	inline std::mutex IOmutex {};
 	
+	// Thread pool. It comes after everything its tasks use, so it is
+	// destroyed first, joining its threads while their data still exists.
+	inline ctpl::thread_pool pool(NUM_THREADS);
+	
 	// Returns the number of thread-seconds since the start of the program.
 	float threadSeconds();
 	
@@ -53,6 +118,24 @@ namespace defs
 	void update(const Subtree& S, indexedList<Graph::vertexID, Graph::numVertices>& border,
 		Graph::vertexID x, std::stack<action>& previous_actions);
 	
+	// Updates the border of S after adding x, does not track changes.
+	void simpleUpdate(const Subtree& S, indexedList<Graph::vertexID, Graph::numVertices>& border,
+		Graph::vertexID x);
+	
+	// Removes every vertex from the border that cannot be added to S. A vertex
+	// only gains neighbors as S grows, so it can never become valid again.
+	void pruneBorder(Subtree& S, indexedList<Graph::vertexID, Graph::numVertices>& border);
+	
+	// Removes every vertex from the border that can no longer be added to S
+	// after adding x. Adding x only changes which neighbors its own neighbors
+	// have, so only border vertices next to x's parent need checking. If the
+	// border held only valid vertices before, it still does.
+	void pruneNear(const Subtree& S, indexedList<Graph::vertexID, Graph::numVertices>& border,
+		Graph::vertexID x, std::stack<action>& previous_actions);
+	
+	// Returns true iff x can be added to S, following pruneEnclosed.
+	bool canAdd(Subtree& S, Graph::vertexID x);
+	
 	// Restores the border of S after removing x.
 	void restore(indexedList<Graph::vertexID, Graph::numVertices>& border,
 		std::stack<action>& previous_actions);
@@ -62,6 +145,142 @@ namespace defs
 	// largestTree and writes the result to outfile, does neither if S
 	// does have enclosed space.
 	void checkCandidate(const Subtree& S);
+	
+	// Builds a Subtree from a tree read from a file, which must fit in the
+	// lattice. Returns nothing if it is empty, disconnected, has a cycle
+	// or breaks the neighbor condition.
+	std::optional<Subtree> loadTree(const StoredTree& t);
+	
+	// Reads a mask laid out like a tree file for exactly this lattice, where
+	// 'X' forces a vertex in, '#' forbids it and '_' leaves it free. Results
+	// then only hold for the mask, so the results cache is not used. Returns
+	// false if the file is missing or malformed.
+	bool loadMask(const std::string& filename);
+	
+	// Upper bounds on the size of a tree that fits in a given slice of the
+	// last dimension and the ones after it, from exact results in the cache.
+	// Vertices are only ever added above the root, so a tree fits in the
+	// lowest slice of any vertex from its root on.
+	inline std::vector<unsigned> sliceBounds {};
+	
+	// Seeds largestTree with the largest cached tree that fits in the lattice,
+	// writes it to outfile, and fills sliceBounds. Returns true iff the cache
+	// already holds the exact answer for this lattice.
+	bool seedFromCache();
+	
+	// Seeds largestTree with the tree in filename, unless it is no larger,
+	// and writes it to outfile. Returns false if the file is missing or the
+	// tree is invalid, has enclosed space or does not fit the mask.
+	bool seedFromTree(const std::string& filename);
+	
+	// Returns an upper bound on the size of any tree rooted at root.
+	unsigned rootBound(Graph::vertexID root);
+	
+	// Stores bestTree in the results cache, as exact only if the search that
+	// produced it is complete. Stores nothing for a mask, or if no tree was
+	// found or seeded.
+	void storeResult(bool exact);
+}
+
+// Border updates run once per added vertex in every engine.
+
+inline void defs::update(const Subtree& S, indexedList<Graph::vertexID, Graph::numVertices>& border,
+	Graph::vertexID x, std::stack<action>& previous_actions)
+{
+	for (Graph::vertexID y : Graph::vertices[x].neighbors)
+	{
+		// Pushes the current action, will need
+		// to do the opposite action to reverse.
+		if (S.cnt(y) > 1)
+		{
+			// This is a fix for the base algorithm, it will
+			// not work without this.
+			if (border.remove(y))
+			{
+				previous_actions.push({rem, static_cast<Graph::storedID>(y)});
+			}
+		}
+		else if (y >= S.root && !S.has(y) && !forbidden[y])
+		{
+			border.push_front(y);
+			previous_actions.push({add, static_cast<Graph::storedID>(y)});
+		}
+	}
+}
+
+inline void defs::simpleUpdate(const Subtree& S,
+	indexedList<Graph::vertexID, Graph::numVertices>& border, Graph::vertexID x)
+{
+	for (Graph::vertexID y : Graph::vertices[x].neighbors)
+	{
+		if (S.cnt(y) > 1)
+		{
+			border.remove(y);
+		}
+		else if (y >= S.root && !S.has(y) && !forbidden[y])
+		{
+			border.push_front(y);
+		}
+	}
+}
+
+inline void defs::pruneBorder(Subtree& S, indexedList<Graph::vertexID, Graph::numVertices>& border)
+{
+	for (Graph::vertexID x : border)
+	{
+		if (!S.safeToAdd(x)) border.remove(x);
+	}
+}
+
+inline void defs::pruneNear(const Subtree& S,
+	indexedList<Graph::vertexID, Graph::numVertices>& border, Graph::vertexID x,
+	std::stack<action>& previous_actions)
+{
+	for (Graph::vertexID p : Graph::vertices[x].neighbors)
+	{
+		if (!S.has(p)) continue;
+		
+		for (Graph::vertexID y : Graph::vertices[p].neighbors)
+		{
+			if (!S.has(y) && !S.safeToAdd(y) && border.remove(y))
+			{
+				previous_actions.push({rem, static_cast<Graph::storedID>(y)});
+			}
+		}
+	}
+}
+
+inline bool defs::canAdd(Subtree& S, Graph::vertexID x)
+{
+	if (!pruneEnclosed) return S.safeToAdd(x);
+	
+	if (!S.add(x)) return false;
+	
+	bool enclosed = S.enclosesSpace(x);
+	S.rem(x);
+	return !enclosed;
+}
+
+inline void defs::restore(indexedList<Graph::vertexID, Graph::numVertices>& border,
+	std::stack<action>& previous_actions)
+{
+	while (true)
+	{
+		action act = previous_actions.top();
+		previous_actions.pop();
+		
+		switch (act.type)
+		{
+			case add:
+				border.remove(act.v);
+				break;
+			case rem:
+				border.push_front(act.v);
+				break;
+			case stop:
+				return;
+		}
+	}
 }
 
 #endif
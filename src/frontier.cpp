@@ -0,0 +1,46 @@
+#include "frontier.hpp"
+
+// Returns the axes of dims with the longest moved to the end.
+static std::vector<unsigned> sweepOrder(const std::vector<unsigned>& dims)
+{
+	std::vector<unsigned> axes(dims.size());
+	for (unsigned d = 0; d < dims.size(); ++d) axes[d] = d;
+	
+	auto longest = std::max_element(axes.begin(), axes.end(),
+		[&](unsigned a, unsigned b) { return dims[a] < dims[b]; });
+	std::rotate(longest, longest + 1, axes.end());
+	
+	return axes;
+}
+
+// Returns dims reordered by axes.
+static std::vector<unsigned> permute(const std::vector<unsigned>& dims,
+	const std::vector<unsigned>& axes)
+{
+	std::vector<unsigned> result;
+	for (unsigned a : axes) result.push_back(dims[a]);
+	return result;
+}
+
+frontier::orientation::orientation(const std::vector<unsigned>& ds) : dims(ds),
+	axes(sweepOrder(ds)), swept(permute(ds, axes)) {}
+
+StoredTree frontier::orientation::unsweep(const std::vector<char>& induced) const
+{
+	StoredTree result(dims);
+	
+	for (unsigned v = 0; v < swept.numVertices(); ++v)
+	{
+		if (!induced[v]) continue;
+		
+		unsigned u = 0, stride = 1;
+		for (unsigned d = 0; d < dims.size(); ++d)
+		{
+			unsigned a = std::find(axes.begin(), axes.end(), d) - axes.begin();
+			u += swept.get_coord(a,v) * stride;
+			stride *= dims[d];
+		}
+		result.add(u);
+	}
+	return result;
+}
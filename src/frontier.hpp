@@ -0,0 +1,314 @@
+#ifndef FRONTIER_HPP
+#define FRONTIER_HPP
+
+#include "lattice.hpp"
+#include "storedTree.hpp"
+
+#include <span>
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+/*
+When the vertices of a Lattice are decided one at a time, in the order they
+are numbered, the only decided vertices that can still gain a neighbor are
+the last slice's worth, where a slice is all vertices with the same last
+coordinate. A frontier records those vertices: whether each is induced,
+which induced ones are already connected, which axes of each could still
+end up with both neighbors, and, unless enclosed space is allowed, which
+empty ones are connected and whether they reach the shell. Everything that
+can happen to the rest of the lattice depends only on the frontier, so
+searches over it take time linear in the last dimension.
+*/
+
+namespace frontier
+{
+	// Each decided vertex in the frontier is one cell.
+	using cell = char16_t;
+	
+	// A cell's label numbers its component, among induced or empty cells. The
+	// mask has a bit for each axis where the backward neighbor is induced and
+	// the forward neighbor is not decided yet. Cells before the first vertex are 0.
+	constexpr cell LABEL = (1 << 6) - 1, INDUCED = 1 << 15, EMPTY = 1 << 14,
+		SHELL = 1 << 13, BOTH = 1 << 12;
+	
+	constexpr unsigned MASK_SHIFT = 6, MAX_DIMENSIONS = 6;
+	
+	constexpr cell MASK = ((1 << MAX_DIMENSIONS) - 1) << MASK_SHIFT;
+	
+	// Label used while merging, never left in a canonical frontier.
+	constexpr cell MERGED = LABEL;
+	
+	// The largest slice a frontier can hold, limited by the number of labels.
+	constexpr unsigned MAX_WIDTH = MERGED - 1;
+	
+	constexpr cell maskBit(unsigned d) { return 1 << (MASK_SHIFT + d); }
+	
+	// A lattice with the axes of dims reordered so that the longest is last,
+	// which keeps the frontier as small as possible.
+	struct orientation
+	{
+		const std::vector<unsigned> dims;
+		
+		// The axis of dims each axis of the swept lattice came from.
+		const std::vector<unsigned> axes;
+		
+		const Lattice swept;
+		
+		orientation(const std::vector<unsigned>& dims);
+		
+		// Returns the vertices of swept marked in induced as a tree in dims.
+		[[nodiscard]] StoredTree unsweep(const std::vector<char>& induced) const;
+	};
+	
+	// What deciding a vertex does to the tree. A closed tree can no longer
+	// grow, so every later vertex must be empty.
+	enum outcome : uint8_t { invalid, open, closed };
+	
+	// The rules for deciding vertices of one lattice.
+	class sweep
+	{
+		public:
+		
+		const Lattice& L;
+		
+		const bool allowEnclosed;
+		
+		// The number of cells in a frontier, the size of one slice.
+		const unsigned width;
+		
+		sweep(const Lattice& l, bool allowEnclosed_) : L(l),
+			allowEnclosed(allowEnclosed_), width(L.numVertices() / L.dims.back()),
+			strides(1, 1)
+		{
+			for (unsigned d = 1; d < L.dims.size(); ++d)
+				strides.push_back(strides.back() * L.dims[d-1]);
+		}
+		
+		// The frontier before any vertex is decided.
+		[[nodiscard]] std::vector<cell> start() const { return std::vector<cell>(width, 0); }
+		
+		// Applies the decision for vertex v to the frontier w, which is left
+		// in canonical form unless the result is invalid.
+		outcome step(std::span<cell> w, unsigned v, bool add) const;
+		
+		// Returns true iff a frontier left after the last vertex is a tree.
+		[[nodiscard]] static bool isTree(std::span<const cell> w)
+		{
+			return std::ranges::any_of(w, [](cell c) { return c & INDUCED; }) &&
+				std::ranges::all_of(w, [](cell c) { return !(c & INDUCED) || (c & LABEL) == 1; });
+		}
+		
+		private:
+		
+		std::vector<unsigned> strides;
+		
+		// A vertex has at most one decided neighbor per axis.
+		using labelList = std::array<cell, MAX_DIMENSIONS>;
+		
+		// Relabels the cells with any of the first n labels, among cells of
+		// the given kind, to MERGED. Returns the cells' flags combined.
+		static cell merge(std::span<cell> w, cell kind, const labelList& labels, unsigned n)
+		{
+			cell flags = 0;
+			for (cell& c : w)
+			{
+				if ((c & kind) && std::find(labels.begin(), labels.begin() + n, c & LABEL)
+					!= labels.begin() + n)
+				{
+					flags |= c;
+					c = (c & ~LABEL) | MERGED;
+				}
+			}
+			return flags;
+		}
+		
+		// Numbers the labels of each kind in order of first appearance, and
+		// drops information that can no longer matter, so that equivalent
+		// frontiers compare equal.
+		void canonicalize(std::span<cell> w) const;
+	};
+	
+	// Returns a hash of the frontier w.
+	[[nodiscard]] inline uint64_t hash(std::span<const cell> w)
+	{
+		uint64_t h = 0;
+		for (cell c : w) h = (h ^ c) * 0x9E3779B97F4A7C15;
+		return h ^ (h >> 32);
+	}
+	
+	// A set of frontiers of the same width, stored end to end, with an
+	// open-addressing index over them so that duplicates are found quickly.
+	// Frontiers are numbered in the order they were added.
+	class stateSet
+	{
+		constexpr static uint32_t EMPTY_SLOT = UINT32_MAX;
+		
+		public:
+		
+		stateSet(unsigned w) : width(w), slots(1 << 10, EMPTY_SLOT) {}
+		
+		[[nodiscard]] uint32_t size() const { return cells.size() / width; }
+		
+		[[nodiscard]] std::span<const cell> operator[](uint32_t i) const
+			{ return { cells.data() + i * width, width }; }
+		
+		void clear()
+		{
+			cells.clear();
+			std::fill(slots.begin(), slots.end(), EMPTY_SLOT);
+		}
+		
+		// Returns the index of w, and true if it was not already here.
+		std::pair<uint32_t, bool> insert(std::span<const cell> w) { return insert(w, hash(w)); }
+		
+		// As above, for when the hash of w is already known.
+		std::pair<uint32_t, bool> insert(std::span<const cell> w, uint64_t h)
+		{
+			if (2 * (size() + 1) > slots.size()) grow();
+			
+			for (size_t slot = h & (slots.size() - 1);; slot = (slot + 1) & (slots.size() - 1))
+			{
+				if (slots[slot] == EMPTY_SLOT)
+				{
+					slots[slot] = size();
+					cells.insert(cells.end(), w.begin(), w.end());
+					return { slots[slot], true };
+				}
+				
+				if (std::ranges::equal((*this)[slots[slot]], w)) return { slots[slot], false };
+			}
+		}
+		
+		private:
+		
+		unsigned width;
+		
+		std::vector<cell> cells;
+		std::vector<uint32_t> slots;
+		
+		void grow()
+		{
+			slots.assign(2 * slots.size(), EMPTY_SLOT);
+			
+			for (uint32_t i = 0; i < size(); ++i)
+			{
+				size_t slot = hash((*this)[i]) & (slots.size() - 1);
+				while (slots[slot] != EMPTY_SLOT) slot = (slot + 1) & (slots.size() - 1);
+				slots[slot] = i;
+			}
+		}
+	};
+	
+	// Stepping is done for every state at every vertex, so it is defined
+	// here where callers can inline it.
+	
+	inline outcome sweep::step(std::span<cell> w, unsigned v, bool add) const
+	{
+		cell result = add ? INDUCED : EMPTY;
+		labelList labels;
+		unsigned numLabels = 0;
+		bool shell = L.onOuterShell(v);
+		
+		auto seen = [&](cell label)
+			{ return std::find(labels.begin(), labels.begin() + numLabels, label)
+				!= labels.begin() + numLabels; };
+		
+		for (unsigned d = 0; d < L.dims.size(); ++d)
+		{
+			if (L.get_coord(d,v) == 0) continue;
+			
+			cell& u = w[width - strides[d]];
+			
+			if (u & INDUCED)
+			{
+				if (add)
+				{
+					// u now has both neighbors on axis d.
+					if (u & maskBit(d))
+					{
+						if (u & BOTH) return invalid;
+						u |= BOTH;
+					}
+					
+					// Joining the same component twice would make a cycle.
+					if (seen(u & LABEL)) return invalid;
+					labels[numLabels++] = u & LABEL;
+					
+					if (L.get_coord(d,v) != L.dims[d] - 1) result |= maskBit(d);
+				}
+				u &= ~maskBit(d);
+			}
+			else if (!add && !allowEnclosed && (u & EMPTY) && !seen(u & LABEL))
+			{
+				labels[numLabels++] = u & LABEL;
+			}
+		}
+		
+		if (add) merge(w, INDUCED, labels, numLabels);
+		else if (!allowEnclosed) shell |= merge(w, EMPTY, labels, numLabels) & SHELL;
+		
+		result |= MERGED;
+		if (!add && !allowEnclosed && shell)
+		{
+			result |= SHELL;
+			for (cell& c : w) if ((c & EMPTY) && (c & LABEL) == MERGED) c |= SHELL;
+		}
+		
+		cell leaving = w.front();
+		std::move(w.begin() + 1, w.end(), w.begin());
+		w.back() = result;
+		
+		auto stillIn = [&](cell kind, cell label)
+		{
+			return std::ranges::any_of(w, [&](cell c)
+				{ return (c & kind) && (c & LABEL) == label; });
+		};
+		
+		outcome o = open;
+		
+		if ((leaving & INDUCED) && !stillIn(INDUCED, leaving & LABEL))
+		{
+			// The component is cut off, so it must be the whole tree.
+			if (std::ranges::any_of(w, [](cell c) { return c & INDUCED; })) return invalid;
+			o = closed;
+		}
+		
+		if (!allowEnclosed && (leaving & EMPTY) && !(leaving & SHELL)
+			&& !stillIn(EMPTY, leaving & LABEL))
+			return invalid;
+		
+		canonicalize(w);
+		return o;
+	}
+	
+	inline void sweep::canonicalize(std::span<cell> w) const
+	{
+		cell inducedMap[LABEL + 1] = {}, emptyMap[LABEL + 1] = {};
+		cell numInduced = 0, numEmpty = 0;
+		
+		for (cell& c : w)
+		{
+			if (c & INDUCED)
+			{
+				cell& l = inducedMap[c & LABEL];
+				if (l == 0) l = ++numInduced;
+				c = (c & ~LABEL) | l;
+				
+				if (!(c & MASK)) c &= ~BOTH;
+			}
+			// Empty cells that reach the shell are all alike.
+			else if ((c & EMPTY) && (c & SHELL)) c = EMPTY | SHELL;
+			else if ((c & EMPTY) && !allowEnclosed)
+			{
+				cell& l = emptyMap[c & LABEL];
+				if (l == 0) l = ++numEmpty;
+				c = (c & ~LABEL) | l;
+			}
+			else if (c & EMPTY) c = EMPTY;
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,69 @@
+#include "frontier.hpp"
+#include "frontierSolver.hpp"
+#include "resultsCache.hpp"
+#include "signals.hpp"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+int main(int num_args, char** args)
+{
+	std::vector<std::string> options(args + 1, args + num_args);
+	
+	bool allowEnclosed = !options.empty() && options.back() == "--allow-enclosed";
+	if (allowEnclosed) options.pop_back();
+	
+	if (options.size() != 2)
+	{
+		std::cerr << "usage: " << args[0] << " <outfile> <A,B,C,...> [--allow-enclosed]"
+			<< std::endl;
+		exit(1);
+	}
+	
+	std::vector<unsigned> dims;
+	std::stringstream sizes(options[1]);
+	for (std::string d; std::getline(sizes, d, ',');) dims.push_back(std::stoi(d));
+	
+	if (dims.empty() || dims.size() > frontier::MAX_DIMENSIONS)
+	{
+		std::cerr << "between 1 and " << frontier::MAX_DIMENSIONS
+			<< " dimensions are supported" << std::endl;
+		exit(1);
+	}
+	
+	const frontier::orientation o(dims);
+	
+	if (o.swept.numVertices() / o.swept.dims.back() > frontier::MAX_WIDTH)
+	{
+		std::cerr << "the cross-section is too large, at most " << frontier::MAX_WIDTH
+			<< " vertices are supported" << std::endl;
+		exit(1);
+	}
+	
+	signals::installSignalHandlers();
+	
+	frontierSolver solver(o.swept, allowEnclosed);
+	unsigned size = solver.solve();
+	
+	StoredTree best = o.unsweep(solver.induced);
+	
+	const char* stopped = solver.stopped ? " (stopped early)" : "";
+	
+	if (allowEnclosed)
+	{
+		best.writeToFile(options[0] + "_enclosed");
+		std::clog << "Largest size (enclosed space allowed) = " << size << stopped << std::endl;
+		return 0;
+	}
+	
+	// A search that was stopped has only a lower bound.
+	best.exact = !solver.stopped;
+	best.writeToFile(options[0]);
+	std::clog << "Largest size (no enclosed space) = " << size << stopped << std::endl;
+	
+	if (size != 0) resultsCache::store(best);
+}
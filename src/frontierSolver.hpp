@@ -0,0 +1,170 @@
+#ifndef FRONTIER_SOLVER_HPP
+#define FRONTIER_SOLVER_HPP
+
+#include "frontier.hpp"
+#include "signals.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <iostream>
+#include <algorithm>
+
+// Finds the exact largest induced subtree of a long, thin prism by dynamic
+// programming over frontiers (see frontier.hpp). Equal frontiers keep only
+// the larger tree, and each step keeps a link back to where every frontier
+// came from so the largest tree can be rebuilt at the end.
+
+class frontierSolver
+{
+	public:
+	
+	frontierSolver(const Lattice& l, bool allowEnclosed) : L(l),
+		rules(l, allowEnclosed) {}
+	
+	// If set, solve prints its progress after each slice.
+	bool verbose = true;
+	
+	// Set if solve stopped early on a signal, in which case its result is
+	// the largest tree that had closed by then, only a lower bound.
+	bool stopped = false;
+	
+	std::vector<char> induced;
+	
+	// Decides every vertex of L, returning the size of the largest tree.
+	// The tree itself is left in induced.
+	unsigned solve()
+	{
+		const unsigned width = rules.width;
+		
+		frontier::stateSet current(width), next(width);
+		std::vector<unsigned> sizes(1, 0), nextSizes;
+		std::vector<frontier::cell> w = rules.start();
+		
+		current.insert(w);
+		links.clear();
+		
+		// The largest tree whose frontier closed before the last vertex.
+		unsigned bestFinished = 0, finishedAt = 0;
+		uint32_t finishedParent = 0;
+		
+		stopped = false;
+		
+		for (unsigned v = 0; v < L.numVertices(); ++v)
+		{
+			// The open frontiers are not trees yet, so only the closed
+			// ones are kept.
+			if (signals::stopRequested)
+			{
+				stopped = true;
+				current.clear();
+				break;
+			}
+			
+			if (verbose && signals::statusRequested)
+			{
+				signals::statusRequested = false;
+				std::clog << "\nvertex " << v << "/" << L.numVertices() << ", " << current.size()
+					<< " states, largest closed tree " << bestFinished << std::endl;
+			}
+			
+			next.clear();
+			nextSizes.clear();
+			links.emplace_back();
+			
+			for (uint32_t i = 0; i < current.size(); ++i)
+			{
+				for (bool add : { false, true })
+				{
+					std::ranges::copy(current[i], w.begin());
+					
+					frontier::outcome o = rules.step(w, v, add);
+					if (o == frontier::invalid) continue;
+					
+					unsigned size = sizes[i] + add;
+					
+					if (o == frontier::closed)
+					{
+						if (size > bestFinished)
+						{
+							bestFinished = size;
+							finishedAt = v;
+							finishedParent = i;
+						}
+						continue;
+					}
+					
+					auto [j, inserted] = next.insert(w);
+					if (inserted)
+					{
+						nextSizes.push_back(size);
+						links.back().push_back({ i, add });
+					}
+					else if (size > nextSizes[j])
+					{
+						nextSizes[j] = size;
+						links.back()[j] = { i, add };
+					}
+				}
+			}
+			
+			std::swap(current, next);
+			std::swap(sizes, nextSizes);
+			
+			if (verbose && (v + 1) % width == 0)
+			{
+				std::clog << "\rslice " << (v + 1) / width << "/" << L.dims.back()
+					<< ", " << current.size() << " states" << std::flush;
+			}
+		}
+		
+		if (verbose) std::clog << std::endl;
+		
+		unsigned best = bestFinished;
+		uint32_t bestEnd = UINT32_MAX;
+		
+		for (uint32_t i = 0; i < current.size(); ++i)
+		{
+			if (frontier::sweep::isTree(current[i]) && sizes[i] > best)
+			{
+				best = sizes[i];
+				bestEnd = i;
+			}
+		}
+		
+		induced.assign(L.numVertices(), false);
+		
+		if (bestEnd != UINT32_MAX) reconstruct(L.numVertices(), bestEnd);
+		else if (best != 0)        reconstruct(finishedAt, finishedParent);
+		
+		return best;
+	}
+	
+	private:
+	
+	const Lattice& L;
+	
+	const frontier::sweep rules;
+	
+	// For each vertex and each state after deciding it, the state it
+	// came from and whether the vertex was induced.
+	struct link
+	{
+		uint32_t parent;
+		bool induced;
+	};
+	
+	std::vector<std::vector<link>> links;
+	
+	// Walks the links back from state i, which is after deciding the
+	// first n vertices.
+	void reconstruct(unsigned n, uint32_t i)
+	{
+		for (unsigned u = n; u-- > 0;)
+		{
+			induced[u] = links[u][i].induced;
+			i = links[u][i].parent;
+		}
+	}
+};
+
+#endif
@@ -1,28 +1,5 @@
 #include "graph.hpp"
 
-constexpr Graph::vertexID Graph::sizeof_dim(unsigned d)
-{
-	return std::accumulate(dim_array.begin(), dim_array.begin() + d,
-		1, std::multiplies<vertexID>());
-}
-
-constexpr Graph::vertexID Graph::get_coord(unsigned d, vertexID c)
-{
-	return (c / sizeof_dim(d)) % dim_array[d];
-}
-
-constexpr Graph::vertexID Graph::forward  (unsigned d, vertexID c)
-{
-	return (get_coord(d,c) == dim_array[d] - 1)
-		? EMPTY : c + sizeof_dim(d);
-}
-
-constexpr Graph::vertexID Graph::backward (unsigned d, vertexID c)
-{
-	return (get_coord(d,c) == 0)
-		? EMPTY : c - sizeof_dim(d);
-}
-
 Graph::graphVertex::graphVertex(vertexID c)
 {
 	// The highest dimension has the largest and smallest neighbors.
@@ -34,8 +11,12 @@ Graph::graphVertex::graphVertex(vertexID c)
 		directions[dim_array.size() + d    ] = forward (d,c);
 	}
 	
-	// Neighbors need to be in ascending order of ID
-	for (vertexID n : directions)
+	// Neighbors need to be in ascending order of ID, which the
+	// directions are only in when numbered in row-major order.
+	auto sorted = directions;
+	std::sort(sorted.begin(), sorted.end());
+	
+	for (vertexID n : sorted)
 	{
 		if (n != EMPTY)
 		{
@@ -44,11 +25,6 @@ Graph::graphVertex::graphVertex(vertexID c)
 	}
 }
 
-bool Graph::onOuterShell(vertexID c)
-{
-	return vertices[c].neighbors.size() != dim_array.size() * 2;
-}
-
 std::array<Graph::graphVertex, Graph::numVertices> Graph::makeVertices()
 {
 	std::array<graphVertex, numVertices> vertices_;
@@ -6,27 +6,36 @@
 
 #include <array>
 #include <numeric>
+#include <algorithm>
 
 /*
 In this case, a Graph is a cubic lattice, with size given
 by SIZEX, SIZEY, and SIZEZ.
+
+Vertices are numbered in row-major order, unless MORTON_ORDER is defined,
+in which case they are numbered along a Z-order curve, so that neighbors
+in every dimension tend to have nearby IDs. Either way, position() gives
+the row-major index of a vertex, which is how trees are stored in files.
 */
 
 class Graph
 {
+	public:
+	
 	// Will eventually be removed in favor of a template
 	static constexpr auto dim_array = std::to_array<unsigned>({ SIZE });
 	
-	public:
-	
 	constexpr static auto numVertices = minFastType<
 		std::accumulate(dim_array.begin(),dim_array.end(),
 			1,std::multiplies<uintmax_t>())
 	>::value;
 	
+	// vertexID is used for arithmetic, storedID for arrays of vertices.
 	using vertexID = std::remove_const<decltype(numVertices)>::type;
+	using storedID = minFastType<numVertices>::least;
 	
-	constexpr static vertexID EMPTY = std::numeric_limits<vertexID>::max();
+	// Fits in both types.
+	constexpr static vertexID EMPTY = std::numeric_limits<storedID>::max();
 	
 	struct graphVertex
 	{
@@ -35,8 +44,8 @@ class Graph
 		// the direction enum below, EMPTY means there
 		// is no vertex in a given direction.
 		
-		semiarray <vertexID, dim_array.size() * 2> neighbors;
-		std::array<vertexID, dim_array.size() * 2> directions;
+		semiarray <storedID, dim_array.size() * 2> neighbors;
+		std::array<storedID, dim_array.size() * 2> directions;
 		
 		graphVertex() {}
 		graphVertex(vertexID);
@@ -70,6 +79,97 @@ class Graph
 	// Returns the vertexID of the vertex "backward" in a
 	// dimension d from c, if it exists, EMPTY if not.
 	[[nodiscard]] static constexpr vertexID backward  (unsigned d, vertexID c);
+	
+	// Returns the row-major index of c.
+	[[nodiscard]] static constexpr vertexID position  (vertexID c);
+	
+	// Returns the vertex with row-major index i.
+	[[nodiscard]] static constexpr vertexID vertexAt  (vertexID i);
+	
+	private:
+	
+	// The row-major index of each vertex, and the vertex at each row-major index.
+	struct numbering
+	{
+		std::array<storedID, numVertices> position, vertexAt;
+	};
+	
+	static constexpr numbering makeNumbering();
+	
+	static const numbering order;
 };
 
+// Defined in the header, since constexpr functions must be visible where they are used.
+
+constexpr Graph::vertexID Graph::sizeof_dim(unsigned d)
+{
+	return std::accumulate(dim_array.begin(), dim_array.begin() + d,
+		1, std::multiplies<vertexID>());
+}
+
+constexpr Graph::numbering Graph::makeNumbering()
+{
+	numbering result {};
+	
+	for (vertexID i = 0; i < numVertices; ++i) result.vertexAt[i] = i;
+	
+	#ifdef MORTON_ORDER
+	// Interleaves the bits of the coordinates, lowest bits first. Dimensions
+	// that are not powers of two leave gaps in the codes, so the vertices are
+	// numbered in the order of their codes instead.
+	std::array<uint64_t, numVertices> code {};
+	for (vertexID i = 0; i < numVertices; ++i)
+	{
+		for (unsigned bit = 0, shift = 0; shift < 64; ++bit)
+		{
+			for (unsigned d = 0; d < dim_array.size() && shift < 64; ++d, ++shift)
+			{
+				code[i] |= uint64_t((i / sizeof_dim(d)) % dim_array[d] >> bit & 1) << shift;
+			}
+		}
+	}
+	
+	std::sort(result.vertexAt.begin(), result.vertexAt.end(),
+		[&](vertexID a, vertexID b) { return code[a] < code[b]; });
+	#endif
+	
+	for (vertexID c = 0; c < numVertices; ++c) result.position[result.vertexAt[c]] = c;
+	
+	return result;
+}
+
+inline constexpr Graph::numbering Graph::order = makeNumbering();
+
+constexpr Graph::vertexID Graph::position (vertexID c)
+{
+	return order.position[c];
+}
+
+constexpr Graph::vertexID Graph::vertexAt (vertexID i)
+{
+	return order.vertexAt[i];
+}
+
+constexpr Graph::vertexID Graph::get_coord(unsigned d, vertexID c)
+{
+	return (position(c) / sizeof_dim(d)) % dim_array[d];
+}
+
+constexpr Graph::vertexID Graph::forward  (unsigned d, vertexID c)
+{
+	return (get_coord(d,c) == dim_array[d] - 1)
+		? EMPTY : vertexAt(position(c) + sizeof_dim(d));
+}
+
+constexpr Graph::vertexID Graph::backward (unsigned d, vertexID c)
+{
+	return (get_coord(d,c) == 0)
+		? EMPTY : vertexAt(position(c) - sizeof_dim(d));
+}
+
+inline bool Graph::onOuterShell(vertexID c)
+{
+	return vertices[c].neighbors.size() != dim_array.size() * 2;
+}
+
 #endif
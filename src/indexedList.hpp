@@ -1,7 +1,10 @@
 #ifndef INDEXED_LIST_HPP
 #define INDEXED_LIST_HPP
 
+#include "minFastType.hpp"
+
 #include <array>
+#include <limits>
 
 /*
 An indexedList is an array/doubly linked list hybrid,
@@ -10,7 +13,8 @@ integers 0-N (excluding N) to be the only candidates
 for the list, without repeats. All insertions and
 removals are in constant time.
 
-T is the type used for indexing.
+T is the type used for indexing. Links are stored in the
+smallest type that can hold N, regardless of T.
 */
 
 template<class T, T N>
@@ -20,7 +24,10 @@ class indexedList
 	
 	struct index;
 	
-	constexpr static T EMPTY = std::numeric_limits<T>::max();
+	using stored = typename minFastType<N>::least;
+	
+	// Fits in both T and stored.
+	constexpr static T EMPTY = std::numeric_limits<stored>::max();
 	
 	public:
 	
@@ -95,17 +102,17 @@ class indexedList
 	struct index
 	{
 		bool inList;
-		T next, prev;
+		stored next, prev;
 		
 		[[nodiscard]] constexpr index() :
 			inList(false), next(EMPTY), prev(EMPTY) {}
 	};
 	
-	unsigned numItems;
+	stored numItems;
 	
 	std::array<index, N> list;
 	
-	T head, tail;
+	stored head, tail;
 };
 
 #include "indexedList.tpp"
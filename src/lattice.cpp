@@ -0,0 +1,98 @@
+#include "lattice.hpp"
+
+Lattice::Lattice(const std::vector<unsigned>& ds, bool wrap_) : dims(ds), wrap(wrap_),
+	_numVertices(1), strides(ds.size())
+{
+	for (unsigned d = 0; d < dims.size(); ++d)
+	{
+		strides[d] = _numVertices;
+		_numVertices *= dims[d];
+	}
+	
+	adj.resize(_numVertices * numDirections());
+	
+	for (unsigned v = 0; v < _numVertices; ++v)
+	{
+		// The highest dimension has the largest and smallest neighbors.
+		// The second highest dimension has the second largest
+		// and second smallest neighbors, etc.
+		for (unsigned d = 0; d < dims.size(); ++d)
+		{
+			unsigned c = get_coord(d,v);
+			
+			unsigned back = (c != 0) ? v - strides[d]
+				: wrap ? v + (dims[d] - 1) * strides[d] : EMPTY;
+			unsigned fwd  = (c != dims[d] - 1) ? v + strides[d]
+				: wrap ? v - (dims[d] - 1) * strides[d] : EMPTY;
+			
+			adj[v * numDirections() + dims.size() - d - 1] = back;
+			adj[v * numDirections() + dims.size() + d    ] = fwd;
+		}
+	}
+}
+
+bool Lattice::onOuterShell(unsigned v) const
+{
+	for (unsigned dir = 0; dir < numDirections(); ++dir)
+	{
+		if (neighbor(v,dir) == EMPTY) return true;
+	}
+	return false;
+}
+
+bool Lattice::validate(const std::vector<char>& induced, unsigned v) const
+{
+	auto exists = [&](unsigned x) { return x != EMPTY && induced[x]; };
+	
+	unsigned axesWithBoth = 0;
+	for (unsigned dir = 0; dir < dims.size(); ++dir)
+	{
+		if (exists(neighbor(v,dir)) && exists(neighbor(v,numDirections() - 1 - dir)))
+			++axesWithBoth;
+	}
+	return axesWithBoth <= 1;
+}
+
+void Lattice::reachFromShell(const std::vector<char>& induced, std::vector<char>& reached) const
+{
+	// Iterative flood fill from every empty vertex on the shell.
+	reached.assign(_numVertices, false);
+	std::vector<unsigned> stack;
+	
+	for (unsigned v = 0; v < _numVertices; ++v)
+	{
+		if (!induced[v] && onOuterShell(v))
+		{
+			reached[v] = true;
+			stack.push_back(v);
+		}
+	}
+	
+	while (!stack.empty())
+	{
+		unsigned v = stack.back();
+		stack.pop_back();
+		
+		for (unsigned dir = 0; dir < numDirections(); ++dir)
+		{
+			unsigned y = neighbor(v,dir);
+			if (y != EMPTY && !induced[y] && !reached[y])
+			{
+				reached[y] = true;
+				stack.push_back(y);
+			}
+		}
+	}
+}
+
+bool Lattice::hasEnclosedSpace(const std::vector<char>& induced) const
+{
+	std::vector<char> reached;
+	reachFromShell(induced, reached);
+	
+	for (unsigned v = 0; v < _numVertices; ++v)
+	{
+		if (!induced[v] && !reached[v]) return true;
+	}
+	return false;
+}
@@ -0,0 +1,58 @@
+#ifndef LATTICE_HPP
+#define LATTICE_HPP
+
+#include <limits>
+#include <vector>
+
+/*
+A Lattice is a cubic lattice whose dimensions are given at runtime rather
+than compile time, optionally with wraparound neighbors (a torus). Vertices
+are numbered as in Graph, and directions are laid out the same way, so the
+direction opposite i is numDirections() - 1 - i.
+*/
+
+class Lattice
+{
+	public:
+	
+	constexpr static unsigned EMPTY = std::numeric_limits<unsigned>::max();
+	
+	const std::vector<unsigned> dims;
+	
+	const bool wrap;
+	
+	Lattice(const std::vector<unsigned>& ds, bool wrap_ = false);
+	
+	[[nodiscard]] unsigned numVertices  () const { return _numVertices; }
+	[[nodiscard]] unsigned numDirections() const { return 2 * dims.size(); }
+	
+	// Returns the neighbor of v in a given direction, EMPTY if there is none.
+	[[nodiscard]] unsigned neighbor(unsigned v, unsigned dir) const
+		{ return adj[v * numDirections() + dir]; }
+	
+	// Gets a specific dimension of the coordinate of v.
+	[[nodiscard]] unsigned get_coord(unsigned d, unsigned v) const
+		{ return (v / strides[d]) % dims[d]; }
+	
+	// Returns true iff v is on the outer shell. A torus has no shell.
+	[[nodiscard]] bool onOuterShell(unsigned v) const;
+	
+	// Returns true iff v has at most one axis with both neighbors induced.
+	[[nodiscard]] bool validate(const std::vector<char>& induced, unsigned v) const;
+	
+	// Marks the empty vertices that can reach the outer shell through
+	// other empty vertices.
+	void reachFromShell(const std::vector<char>& induced, std::vector<char>& reached) const;
+	
+	// Returns true iff some empty vertex cannot reach the outer shell
+	// through other empty vertices.
+	[[nodiscard]] bool hasEnclosedSpace(const std::vector<char>& induced) const;
+	
+	private:
+	
+	unsigned _numVertices;
+	
+	std::vector<unsigned> strides, adj;
+};
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef LAYERED_LIST_HPP
+#define LAYERED_LIST_HPP
+
+#include "minFastType.hpp"
+
+#include <array>
+#include <limits>
+
+/*
+A layeredList is a set of N + 1 singly linked lists (layers), sharing one
+array of links. It requires that each of the integers 0-N (excluding N) is
+in at most one layer at a time, so the whole structure takes O(N) space
+instead of the O(N^2) that N + 1 separate indexedLists would.
+
+T is the type used for indexing.
+*/
+
+template<class T, T N>
+class layeredList
+{
+	using stored = typename minFastType<N>::least;
+	
+	constexpr static stored EMPTY = std::numeric_limits<stored>::max();
+	
+	public:
+	
+	[[nodiscard]] constexpr layeredList()
+	{
+		head.fill(EMPTY);
+		tail.fill(EMPTY);
+	}
+	
+	constexpr void push_back(T layer, T x)
+	{
+		next[x] = EMPTY;
+		
+		if (head[layer] == EMPTY) head[layer] = x;
+		else next[tail[layer]] = x;
+		
+		tail[layer] = x;
+	}
+	
+	[[nodiscard]] constexpr bool empty(T layer) const { return head[layer] == EMPTY; }
+	
+	// Appends every item in a layer to list, in the order they were
+	// added, and empties the layer. If list is empty, this is the same
+	// as swapping the two.
+	template<class List>
+	constexpr void moveTo(T layer, List& list)
+	{
+		for (stored x = head[layer]; x != EMPTY; x = next[x])
+		{
+			list.push_back(x);
+		}
+		
+		head[layer] = tail[layer] = EMPTY;
+	}
+	
+	// Appends every item in a layer to list, in the order they were
+	// added, and leaves the layer as it is.
+	template<class List>
+	constexpr void copyTo(T layer, List& list) const
+	{
+		for (stored x = head[layer]; x != EMPTY; x = next[x])
+		{
+			list.push_back(x);
+		}
+	}
+	
+	private:
+	
+	std::array<stored, N> next;
+	
+	std::array<stored, N + 1> head, tail;
+};
+
+#endif
@@ -0,0 +1,241 @@
+#include "defs.hpp"
+#include "graph.hpp"
+#include "subTree.hpp"
+#include "randomSet.hpp"
+#include "storedTree.hpp"
+
+#include <cmath>
+#include <vector>
+#include <random>
+#include <iostream>
+
+// Improves an existing tree by simulated annealing. A move removes up to
+// K leaves, then regrows the tree randomly until it is maximal, without
+// re-adding the removed vertices. Each thread runs an independent chain.
+
+// Number of moves without improvement before a chain restarts from its best
+// tree, and the temperature schedule used between restarts.
+constexpr unsigned PATIENCE = 100000;
+constexpr double START_TEMPERATURE = 1.0, COOLING = 0.9999;
+
+using vertexSet = randomSet<Graph::vertexID, Graph::numVertices>;
+
+// The tree being improved, along with its leaves and the vertices that could
+// be added to it. These are kept up to date on every addition and removal,
+// which only affect the vertex and its neighbors.
+class chain
+{
+	public:
+	
+	Subtree S;
+	
+	chain(const Subtree& start) : S(start), tabu() { rebuild(); }
+	
+	// Replaces the tree with T.
+	void reset(const Subtree& T)
+	{
+		S = T;
+		rebuild();
+	}
+	
+	// Removes up to k leaves and regrows the tree. Returns the change in size.
+	int move(unsigned k, std::mt19937& rng)
+	{
+		removed.clear();
+		added.clear();
+		
+		unsigned before = S.numInduced;
+		
+		for (unsigned i = 0; i < k && !leaves.empty() && S.numInduced > 1; ++i)
+		{
+			Graph::vertexID x = leaves.random(rng);
+			tabu[x] = true;
+			rem(x);
+			removed.push_back(x);
+		}
+		
+		// Vertices that fail the neighbor condition stay invalid until
+		// a removal, so they can be set aside for the rest of the move.
+		rejected.clear();
+		while (!frontier.empty())
+		{
+			Graph::vertexID x = frontier.random(rng);
+			if (S.safeToAdd(x))
+			{
+				add(x);
+				added.push_back(x);
+			}
+			else
+			{
+				frontier.erase(x);
+				rejected.push_back(x);
+			}
+		}
+		
+		for (Graph::vertexID x : rejected) refresh(x);
+		for (Graph::vertexID x : removed)
+		{
+			tabu[x] = false;
+			refresh(x);
+		}
+		
+		return (int)S.numInduced - (int)before;
+	}
+	
+	// Reverts the last move.
+	void undo()
+	{
+		for (auto it = added.rbegin(); it != added.rend(); ++it) rem(*it);
+		for (auto it = removed.rbegin(); it != removed.rend(); ++it) add(*it);
+	}
+	
+	private:
+	
+	vertexSet leaves, frontier;
+	std::array<bool, Graph::numVertices> tabu;
+	std::vector<Graph::vertexID> removed, added, rejected;
+	
+	// Updates which sets x belongs to.
+	void refresh(Graph::vertexID x)
+	{
+		if (S.has(x))
+		{
+			frontier.erase(x);
+			if (S.cnt(x) <= 1) leaves.insert(x);
+			else               leaves.erase(x);
+		}
+		else
+		{
+			leaves.erase(x);
+			if (S.cnt(x) == 1 && !tabu[x]) frontier.insert(x);
+			else                           frontier.erase(x);
+		}
+	}
+	
+	void rebuild()
+	{
+		leaves.clear();
+		frontier.clear();
+		for (Graph::vertexID x = 0; x < Graph::numVertices; ++x) refresh(x);
+	}
+	
+	void add(Graph::vertexID x)
+	{
+		S.add(x);
+		refresh(x);
+		for (Graph::vertexID y : Graph::vertices[x].neighbors) refresh(y);
+	}
+	
+	void rem(Graph::vertexID x)
+	{
+		S.rem(x);
+		refresh(x);
+		for (Graph::vertexID y : Graph::vertices[x].neighbors) refresh(y);
+	}
+};
+
+void search(int id, const Subtree& start, unsigned k)
+{
+	std::mt19937 rng(time(NULL) + id);
+	std::uniform_real_distribution<double> uniform;
+	
+	chain c(start);
+	
+	Subtree best = start;
+	double temperature = START_TEMPERATURE;
+	unsigned sinceImprovement = 0;
+	
+	while (!defs::stopRequested)
+	{
+		defs::numNodes[id].depth = c.S.numInduced;
+		
+		int delta = c.move(std::uniform_int_distribution<unsigned>(1, k)(rng), rng);
+		++defs::numLeaves[id];
+		
+		if (delta < 0 && uniform(rng) >= std::exp(delta / temperature))
+		{
+			c.undo();
+		}
+		else if (c.S.numInduced > best.numInduced && !c.S.hasEnclosedSpace())
+		{
+			best = c.S;
+			sinceImprovement = 0;
+			
+			if (best.numInduced > defs::largestTree)
+			{
+				defs::checkCandidate(best);
+			}
+		}
+		
+		temperature *= COOLING;
+		
+		if (++sinceImprovement == PATIENCE)
+		{
+			c.reset(best);
+			temperature = START_TEMPERATURE;
+			sinceImprovement = 0;
+		}
+	}
+}
+
+int main(int num_args, char** args)
+{
+	if (num_args < 3 || num_args > 4)
+	{
+		std::cerr << "usage: " << args[0] << " <infile> <outfile> [k]" << std::endl;
+		exit(1);
+	}
+	
+	StoredTree t;
+	if (!t.readFromFile(args[1]))
+	{
+		std::cerr << "error reading " << args[1] << std::endl;
+		exit(1);
+	}
+	
+	auto start = defs::loadTree(t);
+	if (!start)
+	{
+		std::cerr << args[1] << " is not a valid tree for this lattice" << std::endl;
+		exit(1);
+	}
+	
+	defs::outfile = args[2];
+	
+	unsigned k = (num_args == 4) ? std::stoi(args[3]) : 4;
+	
+	defs::start_time = clock();
+	
+	defs::installSignalHandlers();
+	
+	defs::checkCandidate(*start);
+	
+	for (int id = 0; id < defs::NUM_THREADS; ++id)
+	{
+		defs::pool.push(search,*start,k);
+	}
+	
+	// Runs until stopped by a signal.
+	while (!defs::stopRequested)
+	{
+		std::this_thread::sleep_for (std::chrono::seconds(1));
+		
+		if (defs::statusRequested) defs::printStatus();
+		
+		uintmax_t total = 0;
+		for (uintmax_t n : defs::numLeaves) total += n;
+		
+		std::lock_guard<std::mutex> lock(defs::IOmutex);
+		
+		std::clog << "\r" << defs::threadSeconds() << " thread-seconds elapsed, "
+			<< total / defs::threadSeconds() << " moves/thread-second" << std::flush;
+		
+		defs::lastWasNew = false;
+	}
+	
+	defs::pool.stop(true);
+	
+	std::clog << std::endl << "Largest size (no enclosed space) = " << defs::largestTree << std::endl;
+	
+	defs::storeResult(false);
+}
@@ -7,7 +7,10 @@
 /*
 Provides a type which is the minimum fastest
 type that can hold a specified maximum value,
-as well as the value cast to that type.
+as well as the value cast to that type. Also
+provides the smallest such type, for use in
+arrays, where the fast types can be up to 8
+times larger than needed.
 */
 
 template<uintmax_t maxVal>
@@ -18,6 +21,11 @@ struct minFastType
 	             std::conditional_t<maxVal <= UINT32_MAX, uint_fast32_t,
 	                                                      uint_fast64_t>>>;
 	
+	using least = std::conditional_t<maxVal <= UINT8_MAX,  uint_least8_t,
+	              std::conditional_t<maxVal <= UINT16_MAX, uint_least16_t,
+	              std::conditional_t<maxVal <= UINT32_MAX, uint_least32_t,
+	                                                       uint_least64_t>>>;
+	
 	constexpr static type value = static_cast<type>(maxVal);
 };
 
@@ -1,65 +1,167 @@
 #include "defs.hpp"
 #include "graph.hpp"
 #include "subTree.hpp"
+#include "playout.hpp"
+#include "randomSet.hpp"
+#include "playoutBatch.hpp"
+#include "playoutPolicy.hpp"
 #include "indexedList.hpp"
+#include "transpositionTable.hpp"
 
 #include <stack>
+#include <chrono>
+#include <optional>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <sstream>
 #include <iostream>
 #include <random>
 
-// Updates the border of S after adding x, does not track changes.
-void simpleUpdate(Subtree& S,
-	indexedList<Graph::vertexID, Graph::numVertices>& border, Graph::vertexID x)
+thread_local std::mt19937 rng(time(NULL));
+
+// How playouts choose the next vertex, uniform unless set in main.
+playoutPolicy policy;
+
+// If set, level 0 evaluates the border with batchEvaluate.
+bool batchPlayouts = false;
+
+// Results of evaluating a tree at some level, which can be reused when the
+// same tree is reached by adding its vertices in another order.
+transpositionTable<Graph::vertexID, Graph::numVertices> table(64);
+
+// The number of evaluations, and how many of them were found in the table.
+uintmax_t numEvaluations = 0, numReused = 0;
+
+// The level whose decisions are printed, NMC_LEVEL unless the driver
+// in main escalates it.
+unsigned topLevel = NMC_LEVEL;
+
+// Set by --seconds. Searches take no new steps once it has passed or a stop
+// is requested, and their unfinished results are not stored in the table.
+std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+
+bool stopping()
 {
-	for (Graph::vertexID y : Graph::vertices[x].neighbors)
-	{
-		if (S.cnt(y) > 1)
-		{
-			border.remove(y);
-		}
-		else if (y > S.root && !S.has(y))
-		{
-			border.push_front(y);
-		}
-	}
+	return defs::stopRequested || std::chrono::steady_clock::now() >= deadline;
 }
 
-// Randomly adds vertices to S until it becomes maximal, then returns
-// its size.
-// Current path should start with only the last added vertex.
-void randomBranch(int id, Subtree S, indexedList<Graph::vertexID, Graph::numVertices> border,
+// Mixed into a tree's hash to key its evaluation at a given level.
+constexpr uint64_t levelKey(unsigned level) { return (level + 1) * 0x9E3779B97F4A7C15; }
+
+// Randomly adds vertices to S until it becomes maximal, then keeps its
+// path if it is the best so far. Current path should start with only the
+// last added vertex.
+void randomBranch(int id, Subtree S, indexedList<Graph::vertexID, Graph::numVertices>& border,
 	unsigned& bestResult, indexedList<Graph::vertexID, Graph::numVertices> currentPath,
 	indexedList<Graph::vertexID, Graph::numVertices>& bestPath)
 {
-	while(!border.empty())
+	if (playout(id,S,border,policy,rng,currentPath) > bestResult)
 	{
-		Graph::vertexID x;
-		do
-		{
-			// Get and remove a random element,
-			// ensure it is valid.
-			x = border.removeRandom();
-		}
-		while (!S.safeToAdd(x) && !border.empty());
-		
-		// Check for this, not the empty border.
-		if (!S.add(x)) break;
-		
-		simpleUpdate(S,border,x);
-		
-		currentPath.push_back(x);
+		bestResult = S.numInduced;
+		std::swap(bestPath, currentPath);
 	}
+}
+
+// Evaluates every vertex on the border with a playout, as nested_monte_carlo
+// does at level 0, but runs the playouts side by side in a playoutBatch.
+// Lanes left over when the border is small repeat its vertices, and each
+// vertex keeps its best playout.
+void batchEvaluate(int id, Subtree& S, indexedList<Graph::vertexID, Graph::numVertices>& border,
+	unsigned& bestResult, indexedList<Graph::vertexID, Graph::numVertices>& bestPath)
+{
+	using lanes = playoutBatch::lanes;
+	constexpr unsigned NUM_LANES = playoutBatch::NUM_LANES;
+	
+	thread_local playoutBatch batch;
+	thread_local std::mt19937_64 laneRng(time(NULL));
+	
+	// As in the scalar loop, the playout of each vertex may not use
+	// the vertices before it on the border.
+	std::vector<Graph::vertexID> siblings;
+	for (Graph::vertexID x : border) siblings.push_back(x);
+	
+	// Positions in siblings of the vertices not found in the table.
+	std::vector<unsigned> children;
+	std::vector<uint64_t> keys;
 	
-	if (S.numInduced > defs::largestTree)
+	for (unsigned i = 0; i < siblings.size(); ++i)
 	{
-		defs::checkCandidate(S);
+		S.add(siblings[i]);
+		uint64_t key = S.hash ^ levelKey(0);
+		if (key == 0) key = 1;
+		S.rem(siblings[i]);
+		
+		unsigned result = 0;
+		indexedList<Graph::vertexID, Graph::numVertices> found;
+		
+		++numEvaluations;
+		if (table.find(key,result,found))
+		{
+			++numReused;
+			if (result > bestResult)
+			{
+				found.push_front(siblings[i]);
+				bestResult = result;
+				std::swap(bestPath, found);
+			}
+		}
+		else
+		{
+			children.push_back(i);
+			keys.push_back(key);
+		}
 	}
-	++defs::numLeaves[id];
 	
-	if (S.numInduced > bestResult)
+	for (size_t first = 0; first < children.size(); first += NUM_LANES)
 	{
-		bestResult = S.numInduced;
-		std::swap(bestPath, currentPath);
+		size_t n = std::min<size_t>(children.size() - first, NUM_LANES);
+		
+		batch.start(S);
+		for (Graph::vertexID v = 0; v < Graph::numVertices; ++v)
+		{
+			if (defs::forbidden[v]) batch.forbid(~lanes(0), v);
+		}
+		
+		for (unsigned lane = 0; lane < NUM_LANES; ++lane)
+		{
+			unsigned i = children[first + lane % n];
+			
+			batch.add(lanes(1) << lane, siblings[i]);
+			for (unsigned j = 0; j < i; ++j) batch.forbid(lanes(1) << lane, siblings[j]);
+		}
+		
+		batch.run(laneRng);
+		defs::numLeaves[id] += NUM_LANES;
+		
+		auto sizes = batch.sizes();
+		for (size_t c = 0; c < n; ++c)
+		{
+			unsigned best = c;
+			for (unsigned lane = c + n; lane < NUM_LANES; lane += n)
+			{
+				if (sizes[lane] > sizes[best]) best = lane;
+			}
+			
+			std::vector<Graph::vertexID> path = batch.path(best);
+			table.store(keys[first + c],sizes[best],path.begin() + 1,path.end());
+			
+			if (sizes[best] > defs::largestTree)
+			{
+				Subtree T = S;
+				for (Graph::vertexID v : path) T.add(v);
+				defs::checkCandidate(T);
+			}
+			
+			if (sizes[best] > bestResult)
+			{
+				indexedList<Graph::vertexID, Graph::numVertices> p;
+				for (Graph::vertexID v : path) p.push_back(v);
+				
+				bestResult = sizes[best];
+				std::swap(bestPath, p);
+			}
+		}
 	}
 }
 
@@ -69,78 +171,132 @@ void nested_monte_carlo(int id, Subtree& S,
 	indexedList<Graph::vertexID, Graph::numVertices> currentPath,
 	indexedList<Graph::vertexID, Graph::numVertices>& globalBestPath)
 {
-	// Keep track of the vertices added.
-	std::stack<Graph::vertexID> added;
+	// Keep track of the vertices added, and whether each was on the border.
+	std::stack<std::pair<Graph::vertexID, bool>> added;
 	
 	indexedList<Graph::vertexID, Graph::numVertices> bestPath;
 	unsigned bestResult = 0;
+	
+	// A caller that already has a result from here passes it in, and the
+	// search only leaves its path for a better one.
+	if (globalBestResult != 0)
+	{
+		bestPath = globalBestPath;
+		bestPath.pop_front();
+		bestResult = globalBestResult;
+	}
+	
 	while(true)
 	{
-		// Temporarily remove any vertices that are invalid to add.
-		for (Graph::vertexID x : border)
+		if (stopping()) break;
+		
+		if (defs::statusRequested) defs::printStatus();
+		
+		// The border only holds vertices that satisfy the neighbor condition,
+		// but enclosing space is not local, so temporarily remove any vertices
+		// that would enclose space.
+		if (defs::pruneEnclosed)
 		{
-			if (!S.safeToAdd(x))
+			for (Graph::vertexID x : border)
 			{
-				border.remove(x);
-				defs::lists[id][S.numInduced].push_back(x);
+				if (!defs::canAdd(S,x))
+				{
+					border.remove(x);
+					defs::lists[id]->push_back(S.numInduced,x);
+				}
 			}
 		}
 		
 		if (border.empty())
 		{
-			std::swap(border, defs::lists[id][S.numInduced]);
+			defs::lists[id]->moveTo(S.numInduced,border);
 			break;
 		}
 		
-		indexedList<Graph::vertexID, Graph::numVertices> trialPath;
-		do
+		if (level == 0 && batchPlayouts)
 		{
-			// Get and remove the first element
-			Graph::vertexID x = border.pop_front();
-			
-			// Push it onto a temporary list. This is a fix
-			// to the base algorithm, it will not work without this
-			// (along with the swap below)
-			defs::lists[id][S.numInduced].push_back(x);
-			
-			// All additions are valid, so no need to check.
-			S.add(x);
-			
-			previous_actions.push({defs::stop,0});
-			
-			defs::update(S,border,x,previous_actions);
-			
-			trialPath.push_back(x);
-			
-			if (level == 0)
-				randomBranch(id,S,border,bestResult,trialPath,bestPath);
-			else
-				nested_monte_carlo(id,S,border,previous_actions, level - 1,
-					bestResult,trialPath,bestPath);
-			
-			trialPath.pop_back();
-			
-			defs::restore(border,previous_actions);
-			
-			S.rem(x);
+			batchEvaluate(id,S,border,bestResult,bestPath);
+		}
+		else
+		{
+			indexedList<Graph::vertexID, Graph::numVertices> trialPath;
+			do
+			{
+				// Get and remove the first element
+				Graph::vertexID x = border.pop_front();
+				
+				// Push it onto a temporary list. This is a fix
+				// to the base algorithm, it will not work without this
+				// (along with the restore below)
+				defs::lists[id]->push_back(S.numInduced,x);
+				
+				// All additions are valid, so no need to check.
+				S.add(x);
+				
+				previous_actions.push({defs::stop,0});
+				
+				defs::update(S,border,x,previous_actions);
+				defs::pruneNear(S,border,x,previous_actions);
+				
+				trialPath.push_back(x);
+				
+				uint64_t key = S.hash ^ levelKey(level);
+				if (key == 0) key = 1;
+				unsigned trialResult = 0;
+				indexedList<Graph::vertexID, Graph::numVertices> trialBest;
+				
+				++numEvaluations;
+				if (table.find(key,trialResult,trialBest))
+				{
+					trialBest.push_front(x);
+					++numReused;
+				}
+				else
+				{
+					if (level == 0)
+						randomBranch(id,S,border,trialResult,trialPath,trialBest);
+					else
+						nested_monte_carlo(id,S,border,previous_actions, level - 1,
+							trialResult,trialPath,trialBest);
+					
+					// Store what follows x, which is the same however the tree was reached.
+					auto continuation = trialBest.begin();
+					if (!stopping()) table.store(key,trialResult,++continuation,trialBest.end());
+				}
+				
+				if (trialResult > bestResult)
+				{
+					bestResult = trialResult;
+					std::swap(bestPath, trialBest);
+				}
+				
+				trialPath.pop_back();
+				
+				defs::restore(border,previous_actions);
+				
+				S.rem(x);
+			}
+			while (!border.empty());
 		}
-		while (!border.empty());
 		
-		std::swap(border, defs::lists[id][S.numInduced]);
+		defs::lists[id]->moveTo(S.numInduced,border);
 		
 		Graph::vertexID nextVertex = bestPath.pop_front();
 		
 		S.add(nextVertex);
 		
-		added.push(nextVertex);
-		
-		border.remove(nextVertex);
+		// A path from the table may use a vertex that an outer level has
+		// set aside, which is not on the border and must not be put back.
+		added.push({nextVertex, border.remove(nextVertex)});
 		
 		previous_actions.push({defs::stop,0});
 		defs::update(S,border,nextVertex,previous_actions);
+		defs::pruneNear(S,border,nextVertex,previous_actions);
 		
-		if (level == NMC_LEVEL)
+		if (level == topLevel)
 		{
+			defs::numNodes[id].depth = S.numInduced;
+			
 			std::cout << "Level " << level << " decided on vertex "
 				<< static_cast<uintmax_t>(nextVertex) << ", numInduced = "
 				<< S.numInduced << ": " << defs::threadSeconds() << std::endl;
@@ -154,14 +310,14 @@ void nested_monte_carlo(int id, Subtree& S,
 	Graph::vertexID temp = currentPath.pop_front();
 	while(!added.empty())
 	{
-		Graph::vertexID x = added.top();
+		auto [x, onBorder] = added.top();
 		added.pop();
 		
 		S.rem(x);
 		
 		defs::restore(border,previous_actions);
 		
-		border.push_back(x);
+		if (onBorder) border.push_back(x);
 		
 		currentPath.push_front(x);
 	}
@@ -176,34 +332,132 @@ void nested_monte_carlo(int id, Subtree& S,
 
 int main(int num_args, char** args)
 {
-	if (num_args != 2)
+	std::vector<std::string> options(args + std::min(num_args, 2), args + num_args);
+	
+	// If set, ignores NMC_LEVEL and escalates the level until this many seconds pass.
+	unsigned seconds = 0;
+	
+	bool valid = num_args >= 2;
+	for (size_t i = 0; i < options.size() && valid; ++i)
 	{
-		std::cerr << "usage: " << args[0] << " <outfile>" << std::endl;
+		if (options[i] == "--prune-enclosed") defs::pruneEnclosed = true;
+		else if (options[i] == "--batch") batchPlayouts = true;
+		else if (options[i] == "--policy" && i + 1 < options.size())
+		{
+			// Weights for blocked neighbors, depth and the pattern.
+			char comma;
+			std::stringstream weights(options[++i]);
+			valid = static_cast<bool>(weights >> policy.blocked >> comma
+				>> policy.depth >> comma >> policy.pattern);
+		}
+		else if (options[i] == "--pattern" && i + 1 < options.size())
+		{
+			StoredTree motif;
+			valid = motif.readFromFile(options[++i]) && policy.setPattern(motif);
+		}
+		else if (options[i] == "--mask" && i + 1 < options.size()) valid = defs::loadMask(options[++i]);
+		else if (options[i] == "--seconds" && i + 1 < options.size()) seconds = std::stoi(options[++i]);
+		else valid = false;
+	}
+	
+	// Batched playouts are uniform, and cannot see enclosed space as they grow.
+	valid = valid && !(batchPlayouts && (defs::pruneEnclosed || !policy.uniform()));
+	
+	if (!valid)
+	{
+		std::cerr << "usage: " << args[0] << " <outfile> [--prune-enclosed]"
+			" [--policy BLOCKED,DEPTH,PATTERN] [--pattern FILE] [--batch] [--mask FILE]"
+			" [--seconds T]" << std::endl;
 		exit(1);
 	}
 	
 	defs::outfile = args[1];
 	
-	srand(time(NULL));
 	defs::start_time = clock();
 	
+	defs::installSignalHandlers();
+	
+	if (defs::seedFromCache())
+	{
+		std::clog << "Largest size (no enclosed space) = " << defs::largestTree
+			<< " (already known)" << std::endl;
+		return 0;
+	}
+	
+	// Trees grow from the first vertex the mask allows, or from the forced
+	// vertices if there are any, and may use any allowed vertex.
+	Graph::vertexID first = 0;
+	while (first < Graph::numVertices && defs::forbidden[first]) ++first;
+	
+	std::optional<Subtree> start;
+	if (defs::numForced == 0 && first < Graph::numVertices) start.emplace(first);
+	else if (defs::numForced != 0)
+	{
+		StoredTree forced({ Graph::dim_array.begin(), Graph::dim_array.end() });
+		for (Graph::vertexID x = 0; x < Graph::numVertices; ++x)
+		{
+			if (defs::forced[x]) forced.add(Graph::position(x));
+		}
+		start = defs::loadTree(forced);
+	}
+	
+	if (!start)
+	{
+		std::cerr << "the forced vertices do not form a tree" << std::endl;
+		exit(1);
+	}
+	
+	Subtree& S = *start;
+	S.root = first;
+	
 	unsigned globalBestResult = 0;
 	indexedList<Graph::vertexID, Graph::numVertices> currentPath;
-	currentPath.push_front(0);
 	indexedList<Graph::vertexID, Graph::numVertices> globalBestPath;
 	
-	Subtree S(0);
-	
 	indexedList<Graph::vertexID, Graph::numVertices> border;
 	
-	std::stack<defs::action> previous_actions;
+	for (Graph::vertexID x = first; x < Graph::numVertices; ++x)
+	{
+		if (S.has(x) && currentPath.empty()) currentPath.push_front(x);
+		
+		if (!S.has(x) && !defs::forbidden[x] && S.cnt(x) == 1 && S.safeToAdd(x))
+			border.push_back(x);
+	}
 	
-	defs::update(S,border,0,previous_actions);
+	std::stack<defs::action> previous_actions;
 	
-	nested_monte_carlo(0,S,border,previous_actions,NMC_LEVEL,
-		globalBestResult,currentPath,globalBestPath);
+	if (seconds == 0)
+	{
+		nested_monte_carlo(0,S,border,previous_actions,NMC_LEVEL,
+			globalBestResult,currentPath,globalBestPath);
+	}
+	else
+	{
+		// Runs each level in turn until the deadline, each starting from
+		// the best path so far, so every level can only improve on it.
+		deadline = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+		for (topLevel = 0; !stopping(); ++topLevel)
+		{
+			auto begin = std::chrono::steady_clock::now();
+			
+			nested_monte_carlo(0,S,border,previous_actions,topLevel,
+				globalBestResult,currentPath,globalBestPath);
+			
+			std::chrono::duration<float> taken = std::chrono::steady_clock::now() - begin;
+			std::clog << "Level " << topLevel << (stopping() ? " stopped" : " finished")
+				<< " after " << taken.count() << " seconds, largest size " << defs::largestTree << std::endl;
+		}
+	}
 	
 	std::cout << "Monte-Carlo result = " << globalBestResult << std::endl;
+	std::clog << numReused << " of " << numEvaluations
+		<< " evaluations found in the transposition table" << std::endl;
+	
+	uintmax_t numPlayouts = 0;
+	for (uintmax_t n : defs::numLeaves) numPlayouts += n;
+	
+	std::clog << numPlayouts << " playouts, " << numPlayouts / defs::threadSeconds()
+		<< " playouts/thread-second" << std::endl;
 	
 	//pool.push(randomSample,0);
 	
@@ -229,5 +483,8 @@ int main(int num_args, char** args)
 	
 	//std::clog << threadSeconds() << " thread-seconds" << std::endl;
 	
-	std::clog << "Largest size (no enclosed space) = " << defs::largestTree << std::endl;
+	std::clog << "Largest size (no enclosed space) = " << defs::largestTree
+		<< (defs::stopRequested ? " (stopped early)" : "") << std::endl;
+	
+	defs::storeResult(false);
 }
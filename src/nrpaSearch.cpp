@@ -0,0 +1,196 @@
+#include "defs.hpp"
+#include "graph.hpp"
+#include "subTree.hpp"
+#include "indexedList.hpp"
+
+#include <cmath>
+#include <vector>
+#include <random>
+#include <iostream>
+
+// Nested Rollout Policy Adaptation, based on the paper at
+// https://www.ijcai.org/Proceedings/11/Papers/115.pdf. Moves are coded by
+// the vertex they add, and each worker runs an independent search.
+
+using policy = std::array<double, Graph::numVertices>;
+using sequence = std::vector<Graph::vertexID>;
+
+// Number of iterations at each level, and the learning rate.
+constexpr unsigned ITERATIONS = 100;
+constexpr double ALPHA = 1.0;
+
+thread_local std::mt19937 rng;
+
+// The state every rollout starts from, a tree containing only vertex 0.
+struct startState
+{
+	Subtree S;
+	indexedList<Graph::vertexID, Graph::numVertices> border;
+	
+	startState() : S(0)
+	{
+		defs::simpleUpdate(S,border,0);
+	}
+};
+
+// Adds x to S, which must be valid to add.
+void apply(Subtree& S, indexedList<Graph::vertexID, Graph::numVertices>& border,
+	Graph::vertexID x)
+{
+	S.add(x);
+	border.remove(x);
+	defs::simpleUpdate(S,border,x);
+}
+
+// Performs a playout, choosing each vertex with probability proportional
+// to exp(pol[x]). Stores the vertices added in seq and returns the size.
+unsigned playout(int id, const policy& pol, sequence& seq)
+{
+	startState state;
+	auto& [S, border] = state;
+	
+	seq.clear();
+	
+	std::vector<Graph::vertexID> moves;
+	std::vector<double> weights;
+	while (true)
+	{
+		defs::pruneBorder(S,border);
+		
+		if (border.empty()) break;
+		
+		moves.clear();
+		weights.clear();
+		for (Graph::vertexID x : border)
+		{
+			moves.push_back(x);
+			weights.push_back(std::exp(pol[x]));
+		}
+		
+		std::discrete_distribution<unsigned> choose(weights.begin(), weights.end());
+		Graph::vertexID x = moves[choose(rng)];
+		
+		apply(S,border,x);
+		seq.push_back(x);
+	}
+	
+	if (S.numInduced > defs::largestTree)
+	{
+		defs::checkCandidate(S);
+	}
+	++defs::numLeaves[id];
+	
+	return S.numInduced;
+}
+
+// Moves pol towards seq by replaying it from the start.
+void adapt(policy& pol, const sequence& seq)
+{
+	startState state;
+	auto& [S, border] = state;
+	
+	policy result = pol;
+	for (Graph::vertexID chosen : seq)
+	{
+		defs::pruneBorder(S,border);
+		
+		double z = 0;
+		for (Graph::vertexID x : border) z += std::exp(pol[x]);
+		
+		for (Graph::vertexID x : border)
+		{
+			result[x] -= ALPHA * std::exp(pol[x]) / z;
+		}
+		result[chosen] += ALPHA;
+		
+		apply(S,border,chosen);
+	}
+	
+	pol = result;
+}
+
+unsigned nrpa(int id, unsigned level, policy pol, sequence& bestSeq, bool top)
+{
+	if (level == 0) return playout(id,pol,bestSeq);
+	
+	unsigned bestResult = 0;
+	sequence seq;
+	for (unsigned i = 0; i < ITERATIONS && !defs::stopRequested; ++i)
+	{
+		unsigned result = nrpa(id,level - 1,pol,seq,false);
+		
+		if (result >= bestResult)
+		{
+			bestResult = result;
+			std::swap(bestSeq, seq);
+		}
+		
+		adapt(pol,bestSeq);
+		
+		if (top)
+		{
+			uintmax_t total = 0;
+			for (uintmax_t n : defs::numLeaves) total += n;
+			
+			std::lock_guard<std::mutex> lock(defs::IOmutex);
+			
+			std::cout << "Thread " << id << ", iteration " << i + 1 << ": best = "
+				<< bestResult << ", " << total / defs::threadSeconds()
+				<< " playouts/thread-second" << std::endl;
+			
+			defs::lastWasNew = false;
+		}
+	}
+	
+	return bestResult;
+}
+
+void search(int id, unsigned level)
+{
+	rng.seed(time(NULL) + id);
+	
+	policy pol {};
+	sequence bestSeq;
+	nrpa(id,level,pol,bestSeq,true);
+}
+
+int main(int num_args, char** args)
+{
+	if (num_args < 2 || num_args > 3)
+	{
+		std::cerr << "usage: " << args[0] << " <outfile> [level]" << std::endl;
+		exit(1);
+	}
+	
+	defs::outfile = args[1];
+	
+	unsigned level = (num_args == 3) ? std::stoi(args[2]) : 2;
+	
+	defs::start_time = clock();
+	
+	defs::installSignalHandlers();
+	
+	if (defs::seedFromCache())
+	{
+		std::clog << "Largest size (no enclosed space) = " << defs::largestTree
+			<< " (already known)" << std::endl;
+		return 0;
+	}
+	
+	std::vector<std::future<void>> done;
+	for (int id = 0; id < defs::NUM_THREADS; ++id)
+	{
+		done.push_back(defs::pool.push(search,level));
+	}
+	
+	for (auto& f : done) defs::waitFor(f);
+	
+	uintmax_t total = 0;
+	for (uintmax_t n : defs::numLeaves) total += n;
+	
+	std::clog << "Largest size (no enclosed space) = " << defs::largestTree << ", "
+		<< total << " playouts in " << defs::threadSeconds() << " thread-seconds"
+		<< (defs::stopRequested ? " (stopped early)" : "") << std::endl;
+	
+	defs::storeResult(false);
+}
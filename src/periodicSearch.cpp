@@ -0,0 +1,446 @@
+#include "lattice.hpp"
+#include "signals.hpp"
+#include "storedTree.hpp"
+#include "resultsCache.hpp"
+
+#include <cmath>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+#include <sstream>
+#include <iostream>
+
+// Searches for periodic constructions on lattices too large to search directly.
+// A motif is a set of vertices of a torus with side length equal to the period.
+// Motifs are scored by tiling them over a larger torus, which has no boundary,
+// and growing a tree through them, less the number of pockets of enclosed
+// space it would have once unrolled. Whenever a motif scores better than any
+// seen so far, it is tiled over the real lattice at every offset, the boundary
+// is repaired by growing the tree through any remaining vertex, and any
+// enclosed space is opened by removing leaves.
+
+// Side length of the torus motifs are scored on is the smallest
+// multiple of the period that is at least this.
+constexpr unsigned TORUS_SIZE = 8;
+
+// Moves without improvement before a thread restarts from a random motif.
+constexpr unsigned PATIENCE = 20000;
+constexpr double TEMPERATURE = 0.5;
+
+using clock_type = std::chrono::steady_clock;
+
+// Grows induced trees in a Lattice.
+class treeGrower
+{
+	public:
+	
+	const Lattice& L;
+	
+	std::vector<char> induced;
+	
+	unsigned numInduced;
+	
+	treeGrower(const Lattice& l) : L(l) {}
+	
+	// Grows a maximal tree from seed in breadth-first order, first only
+	// through preferred vertices, then through any vertex.
+	unsigned grow(unsigned seed, const std::vector<char>& preferred)
+	{
+		induced.assign(L.numVertices(), false);
+		cnt.assign(L.numVertices(), 0);
+		order.clear();
+		numInduced = 0;
+		
+		add(seed);
+		
+		for (bool any : { false, true })
+		{
+			for (unsigned i = 0; i < order.size(); ++i)
+			{
+				for (unsigned dir = 0; dir < L.numDirections(); ++dir)
+				{
+					unsigned y = L.neighbor(order[i],dir);
+					if (y != Lattice::EMPTY && (any || preferred[y]) && canAdd(y))
+					{
+						add(y);
+					}
+				}
+			}
+		}
+		
+		return numInduced;
+	}
+	
+	// Removes leaves next to enclosed space until there is none, preferring
+	// leaves that also touch space reachable from the shell. Returns false
+	// if there is enclosed space with no leaf next to it.
+	bool openEnclosedSpace()
+	{
+		std::vector<char> reached;
+		while (true)
+		{
+			L.reachFromShell(induced, reached);
+			
+			unsigned best = Lattice::EMPTY, fallback = Lattice::EMPTY;
+			bool enclosed = false;
+			for (unsigned v = 0; v < L.numVertices() && best == Lattice::EMPTY; ++v)
+			{
+				if (!induced[v])
+				{
+					enclosed |= !reached[v];
+					continue;
+				}
+				
+				if (cnt[v] != 1) continue;
+				
+				bool touchesEnclosed = false, touchesReached = L.onOuterShell(v);
+				for (unsigned dir = 0; dir < L.numDirections(); ++dir)
+				{
+					unsigned y = L.neighbor(v,dir);
+					if (y == Lattice::EMPTY || induced[y]) continue;
+					
+					touchesEnclosed |= !reached[y];
+					touchesReached  |=  reached[y];
+				}
+				
+				if (touchesEnclosed)
+				{
+					enclosed = true;
+					if (touchesReached) best = v;
+					else fallback = v;
+				}
+			}
+			
+			if (!enclosed) return true;
+			
+			if (best == Lattice::EMPTY) best = fallback;
+			if (best == Lattice::EMPTY || numInduced == 1) return false;
+			
+			rem(best);
+		}
+	}
+	
+	private:
+	
+	// Number of induced neighbors of each vertex.
+	std::vector<unsigned char> cnt;
+	
+	// Induced vertices in the order they were added.
+	std::vector<unsigned> order;
+	
+	// Returns true iff y has exactly one induced neighbor,
+	// and adding y would preserve the neighbor condition.
+	bool canAdd(unsigned y)
+	{
+		if (induced[y] || cnt[y] != 1) return false;
+		
+		unsigned dir = 0;
+		while (L.neighbor(y,dir) == Lattice::EMPTY || !induced[L.neighbor(y,dir)]) ++dir;
+		
+		induced[y] = true;
+		bool result = L.validate(induced, L.neighbor(y,dir));
+		induced[y] = false;
+		
+		return result;
+	}
+	
+	void add(unsigned y)
+	{
+		induced[y] = true;
+		++numInduced;
+		order.push_back(y);
+		
+		for (unsigned dir = 0; dir < L.numDirections(); ++dir)
+		{
+			unsigned x = L.neighbor(y,dir);
+			if (x != Lattice::EMPTY) ++cnt[x];
+		}
+	}
+	
+	void rem(unsigned y)
+	{
+		induced[y] = false;
+		--numInduced;
+		
+		for (unsigned dir = 0; dir < L.numDirections(); ++dir)
+		{
+			unsigned x = L.neighbor(y,dir);
+			if (x != Lattice::EMPTY) --cnt[x];
+		}
+	}
+};
+
+// Returns the number of empty components of a torus that do not wrap around
+// it. Each of these is enclosed space once the torus is unrolled, and needs
+// at least one vertex removed to open it.
+unsigned countPockets(const Lattice& torus, const std::vector<char>& induced)
+{
+	const unsigned D = torus.dims.size();
+	
+	// The coordinates of each visited vertex in the unrolled lattice.
+	std::vector<int> lifted(torus.numVertices() * D);
+	std::vector<char> visited(torus.numVertices(), false);
+	std::vector<unsigned> stack;
+	
+	unsigned pockets = 0;
+	for (unsigned start = 0; start < torus.numVertices(); ++start)
+	{
+		if (induced[start] || visited[start]) continue;
+		
+		visited[start] = true;
+		for (unsigned d = 0; d < D; ++d) lifted[start * D + d] = torus.get_coord(d,start);
+		stack.push_back(start);
+		
+		bool wraps = false;
+		while (!stack.empty())
+		{
+			unsigned v = stack.back();
+			stack.pop_back();
+			
+			for (unsigned dir = 0; dir < torus.numDirections(); ++dir)
+			{
+				unsigned y = torus.neighbor(v,dir);
+				if (induced[y]) continue;
+				
+				// Directions below D are backward along axis D - 1 - dir.
+				unsigned axis = (dir < D) ? D - 1 - dir : dir - D;
+				int step = (dir < D) ? -1 : 1;
+				
+				if (!visited[y])
+				{
+					visited[y] = true;
+					for (unsigned d = 0; d < D; ++d) lifted[y * D + d] = lifted[v * D + d];
+					lifted[y * D + axis] += step;
+					stack.push_back(y);
+				}
+				else if (lifted[y * D + axis] != lifted[v * D + axis] + step)
+				{
+					wraps = true;
+				}
+			}
+		}
+		
+		if (!wraps) ++pockets;
+	}
+	
+	return pockets;
+}
+
+// Marks the vertices of L covered by motif, tiled starting at a given offset.
+void tile(const Lattice& L, const Lattice& motifTorus, const std::vector<char>& motif,
+	unsigned offset, std::vector<char>& result)
+{
+	result.resize(L.numVertices());
+	for (unsigned v = 0; v < L.numVertices(); ++v)
+	{
+		unsigned m = 0, stride = 1;
+		for (unsigned d = 0; d < L.dims.size(); ++d)
+		{
+			unsigned p = motifTorus.dims[d];
+			m += (L.get_coord(d,v) + motifTorus.get_coord(d,offset)) % p * stride;
+			stride *= p;
+		}
+		result[v] = motif[m];
+	}
+}
+
+// Returns the first preferred vertex, or 0 if there is none.
+unsigned firstPreferred(const std::vector<char>& preferred)
+{
+	for (unsigned v = 0; v < preferred.size(); ++v)
+	{
+		if (preferred[v]) return v;
+	}
+	return 0;
+}
+
+// State shared between the threads.
+namespace shared
+{
+	std::mutex mutex;
+	
+	std::atomic<uintmax_t> motifsEvaluated = 0, repairs = 0;
+	
+	unsigned bestTorusScore = 0;
+	
+	// Written under the mutex. Its size is kept in bestSize too, which
+	// threads can check without taking the mutex.
+	StoredTree best;
+	std::atomic<unsigned> bestSize = 0;
+	
+	std::string outfile;
+	
+	clock_type::time_point start, deadline;
+	
+	double secondsElapsed()
+	{
+		return std::chrono::duration<double>(clock_type::now() - start).count();
+	}
+	
+	// Searches take no new steps once the deadline has passed or a stop
+	// is requested.
+	bool running()
+	{
+		return clock_type::now() < deadline && !signals::stopRequested;
+	}
+}
+
+// Tiles motif over the lattice at every offset and repairs each, keeping any
+// tree larger than the best so far that has no enclosed space.
+void repair(const Lattice& box, const Lattice& motifTorus, const std::vector<char>& motif)
+{
+	treeGrower grower(box);
+	std::vector<char> preferred;
+	
+	for (unsigned offset = 0; offset < motifTorus.numVertices(); ++offset)
+	{
+		tile(box, motifTorus, motif, offset, preferred);
+		
+		grower.grow(firstPreferred(preferred), preferred);
+		++shared::repairs;
+		
+		if (grower.numInduced <= shared::bestSize || !grower.openEnclosedSpace())
+			continue;
+		
+		unsigned size = grower.numInduced;
+		
+		std::lock_guard<std::mutex> lock(shared::mutex);
+		
+		if (size > shared::best.numInduced)
+		{
+			shared::best = StoredTree(box.dims);
+			for (unsigned v = 0; v < box.numVertices(); ++v)
+			{
+				if (grower.induced[v]) shared::best.add(v);
+			}
+			shared::bestSize = size;
+			shared::best.writeToFile(shared::outfile);
+			
+			std::clog << "\n" << size << " vertices, found at "
+				<< shared::secondsElapsed() << " seconds" << std::endl;
+		}
+	}
+}
+
+// Simulated annealing over motifs.
+void search(unsigned id, const Lattice& box, unsigned period)
+{
+	std::mt19937 rng(time(NULL) + id);
+	std::uniform_real_distribution<double> uniform;
+	
+	const Lattice motifTorus(std::vector<unsigned>(box.dims.size(), period), true);
+	const Lattice torus(std::vector<unsigned>(box.dims.size(),
+		(TORUS_SIZE + period - 1) / period * period), true);
+	
+	treeGrower grower(torus);
+	std::vector<char> motif(motifTorus.numVertices()), preferred;
+	
+	auto score = [&]()
+	{
+		tile(torus, motifTorus, motif, 0, preferred);
+		++shared::motifsEvaluated;
+		
+		unsigned size = grower.grow(firstPreferred(preferred), preferred);
+		unsigned pockets = countPockets(torus, grower.induced);
+		return (size > pockets) ? size - pockets : 0;
+	};
+	
+	while (shared::running())
+	{
+		for (char& m : motif) m = rng() % 2;
+		
+		unsigned current = score(), best = current;
+		
+		for (unsigned sinceImprovement = 0; sinceImprovement < PATIENCE
+			&& shared::running(); ++sinceImprovement)
+		{
+			unsigned v = rng() % motif.size();
+			motif[v] = !motif[v];
+			
+			unsigned next = score();
+			
+			if (next < current && uniform(rng) >= std::exp(((double)next - current) / TEMPERATURE))
+			{
+				motif[v] = !motif[v];
+				continue;
+			}
+			
+			current = next;
+			
+			if (current <= best) continue;
+			
+			best = current;
+			sinceImprovement = 0;
+			
+			{
+				std::lock_guard<std::mutex> lock(shared::mutex);
+				if (current <= shared::bestTorusScore) continue;
+				shared::bestTorusScore = current;
+			}
+			
+			repair(box, motifTorus, motif);
+		}
+	}
+}
+
+int main(int num_args, char** args)
+{
+	if (num_args < 3 || num_args > 5)
+	{
+		std::cerr << "usage: " << args[0] << " <outfile> <A,B,C,...> [period] [seconds]"
+			<< std::endl;
+		exit(1);
+	}
+	
+	shared::outfile = args[1];
+	
+	std::vector<unsigned> dims;
+	std::stringstream sizes(args[2]);
+	for (std::string d; std::getline(sizes, d, ',');) dims.push_back(std::stoi(d));
+	
+	unsigned period  = (num_args >= 4) ? std::stoi(args[3]) : 4;
+	unsigned seconds = (num_args >= 5) ? std::stoi(args[4]) : 60;
+	
+	const Lattice box(dims);
+	
+	shared::best = StoredTree(dims);
+	shared::start = clock_type::now();
+	shared::deadline = shared::start + std::chrono::seconds(seconds);
+	
+	signals::installSignalHandlers();
+	
+	std::vector<std::thread> threads;
+	for (unsigned id = 0; id < std::max(1u, std::thread::hardware_concurrency()); ++id)
+	{
+		threads.emplace_back(search, id, std::cref(box), period);
+	}
+	
+	while (shared::running())
+	{
+		std::this_thread::sleep_for (std::chrono::seconds(1));
+		
+		std::lock_guard<std::mutex> lock(shared::mutex);
+		
+		if (signals::statusRequested)
+		{
+			signals::statusRequested = false;
+			std::clog << "\n" << shared::secondsElapsed() << " seconds: largest size " << shared::bestSize
+				<< ", " << shared::motifsEvaluated << " motifs, " << shared::repairs << " repairs, "
+				<< "best torus score " << shared::bestTorusScore << std::endl;
+		}
+		
+		std::clog << "\r" << shared::secondsElapsed() << " seconds elapsed, "
+			<< shared::motifsEvaluated / shared::secondsElapsed() << " motifs/second, "
+			<< shared::repairs / shared::secondsElapsed() << " repairs/second" << std::flush;
+	}
+	
+	for (auto& t : threads) t.join();
+	
+	std::clog << std::endl << "Largest size (no enclosed space) = " << shared::best.numInduced
+		<< (signals::stopRequested ? " (stopped early)" : "") << std::endl;
+	
+	if (shared::best.numInduced != 0) resultsCache::store(shared::best);
+}
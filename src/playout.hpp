@@ -0,0 +1,86 @@
+#ifndef PLAYOUT_HPP
+#define PLAYOUT_HPP
+
+#include "defs.hpp"
+#include "graph.hpp"
+#include "subTree.hpp"
+#include "randomSet.hpp"
+#include "indexedList.hpp"
+#include "playoutPolicy.hpp"
+
+// Random playouts, shared by the engines that score trees by growing them
+// at random until they are maximal.
+
+using vertexSet = randomSet<Graph::vertexID, Graph::numVertices>;
+
+// Discards the vertices added by a playout, for callers that do not need them.
+struct noPath
+{
+	void push_back(Graph::vertexID) {}
+};
+
+// Updates the set of vertices that can be added to S after adding x. Only
+// vertices next to x or to its parent can have changed.
+inline void updateAddable(const Subtree& S, vertexSet& addable, Graph::vertexID x)
+{
+	addable.erase(x);
+	
+	for (Graph::vertexID y : Graph::vertices[x].neighbors)
+	{
+		if (S.has(y))
+		{
+			for (Graph::vertexID z : Graph::vertices[y].neighbors)
+			{
+				if (addable.exists(z) && !S.safeToAdd(z)) addable.erase(z);
+			}
+		}
+		else if (S.cnt(y) > 1) addable.erase(y);
+		else if (y >= S.root && !defs::forbidden[y] && S.safeToAdd(y)) addable.insert(y);
+	}
+}
+
+// Adds vertices to S, each drawn at random from those that can be added and
+// accepted by policy, until S is maximal, and appends them to path. Vertices
+// of the border that can no longer be added are skipped. Then reports S as a
+// candidate, counts a leaf for thread id and returns the size of S.
+template<class URBG, class Path>
+unsigned playout(int id, Subtree& S, indexedList<Graph::vertexID, Graph::numVertices>& border,
+	const playoutPolicy& policy, URBG& rng, Path& path)
+{
+	vertexSet addable;
+	for (Graph::vertexID x : border)
+	{
+		if (S.safeToAdd(x)) addable.insert(x);
+	}
+	
+	while (!addable.empty())
+	{
+		Graph::vertexID x = addable.random(rng);
+		
+		if (!policy.accept(S,x,rng)) continue;
+		
+		// Whether x encloses space depends on the whole tree, so it
+		// is not tracked in addable and has to be checked here.
+		if (defs::pruneEnclosed && !defs::canAdd(S,x))
+		{
+			addable.erase(x);
+			continue;
+		}
+		
+		S.add(x);
+		
+		updateAddable(S,addable,x);
+		
+		path.push_back(x);
+	}
+	
+	if (S.numInduced > defs::largestTree)
+	{
+		defs::checkCandidate(S);
+	}
+	++defs::numLeaves[id];
+	
+	return S.numInduced;
+}
+
+#endif
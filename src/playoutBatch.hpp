@@ -0,0 +1,161 @@
+#ifndef PLAYOUT_BATCH_HPP
+#define PLAYOUT_BATCH_HPP
+
+#include "graph.hpp"
+#include "subTree.hpp"
+
+#include <bit>
+#include <array>
+#include <vector>
+#include <random>
+#include <cstdint>
+#include <numeric>
+#include <algorithm>
+
+/*
+A playoutBatch grows 64 random trees at once, one per bit (lane) of a
+64-bit word. For each vertex it keeps a word with the lanes where the
+vertex is induced, and another with the lanes where it has an axis with
+both neighbors induced, so whether a vertex can be added is found for
+every lane at once with a few bitwise operations.
+
+Trees grow in rounds. Each round visits the vertices in a new random
+order, and adds each vertex to a random half of the lanes it can be added
+to. Rounds stop once no vertex can be added to any lane, at which point
+every lane holds a maximal tree.
+*/
+
+class playoutBatch
+{
+	public:
+	
+	using lanes = uint64_t;
+	
+	constexpr static unsigned NUM_LANES = 64;
+	
+	// Sets every lane to S, with nothing forbidden.
+	void start(const Subtree& S)
+	{
+		root = S.root;
+		events.clear();
+		
+		for (Graph::vertexID v = 0; v < Graph::numVertices; ++v)
+		{
+			induced[v] = S.has(v) ? ~lanes(0) : 0;
+			forbidden[v] = 0;
+			
+			// Induced vertices with an axis that has both neighbors induced.
+			bool full = false;
+			auto& dirs = Graph::vertices[v].directions;
+			for (unsigned k = 0; k < Graph::dim_array.size(); ++k)
+			{
+				full |= S.exists(dirs[k]) && S.exists(dirs[dirs.size() - 1 - k]);
+			}
+			fullAxis[v] = S.has(v) && full ? ~lanes(0) : 0;
+		}
+	}
+	
+	// Adds v in the lanes of m, where it must be valid to add.
+	void add(lanes m, Graph::vertexID v)
+	{
+		induced[v] |= m;
+		events.push_back({ static_cast<Graph::storedID>(v), m });
+		
+		// Only the parent of v gains a neighbor, and it gains a full axis
+		// if the vertex on its other side is induced.
+		auto& dirs = Graph::vertices[v].directions;
+		for (unsigned k = 0; k < dirs.size(); ++k)
+		{
+			Graph::vertexID u = dirs[k];
+			if (u == Graph::EMPTY) continue;
+			
+			Graph::vertexID w = Graph::vertices[u].directions[k];
+			if (w != Graph::EMPTY) fullAxis[u] |= m & induced[u] & induced[w];
+		}
+	}
+	
+	// Keeps v out of the lanes of m.
+	void forbid(lanes m, Graph::vertexID v) { forbidden[v] |= m; }
+	
+	// Returns the lanes where v can be added.
+	[[nodiscard]] lanes addable(Graph::vertexID v) const
+	{
+		lanes one = 0, two = 0, invalid = 0;
+		
+		auto& dirs = Graph::vertices[v].directions;
+		for (unsigned k = 0; k < dirs.size(); ++k)
+		{
+			Graph::vertexID u = dirs[k];
+			if (u == Graph::EMPTY) continue;
+			
+			two |= one & induced[u];
+			one |= induced[u];
+			
+			// If u is the parent, it would gain a second full axis.
+			Graph::vertexID w = Graph::vertices[u].directions[k];
+			if (w != Graph::EMPTY) invalid |= induced[u] & fullAxis[u] & induced[w];
+		}
+		
+		return one & ~two & ~invalid & ~induced[v] & ~forbidden[v];
+	}
+	
+	// Grows every lane until its tree is maximal.
+	template<class URBG>
+	void run(URBG& g)
+	{
+		static_assert(URBG::max() == UINT64_MAX, "every lane needs a random bit");
+		
+		std::vector<Graph::storedID> order(Graph::numVertices - root);
+		std::iota(order.begin(), order.end(), root);
+		
+		for (lanes any = ~lanes(0); any != 0;)
+		{
+			any = 0;
+			std::shuffle(order.begin(), order.end(), g);
+			
+			for (Graph::vertexID v : order)
+			{
+				lanes m = addable(v);
+				if (m == 0) continue;
+				
+				any |= m;
+				
+				m &= g();
+				if (m != 0) add(m,v);
+			}
+		}
+	}
+	
+	// Returns the number of vertices induced in each lane.
+	[[nodiscard]] std::array<unsigned, NUM_LANES> sizes() const
+	{
+		std::array<unsigned, NUM_LANES> result {};
+		for (lanes m : induced)
+		{
+			for (; m != 0; m &= m - 1) ++result[std::countr_zero(m)];
+		}
+		return result;
+	}
+	
+	// Returns the vertices added to a lane since start, in order.
+	[[nodiscard]] std::vector<Graph::vertexID> path(unsigned lane) const
+	{
+		std::vector<Graph::vertexID> result;
+		for (auto [v, m] : events)
+		{
+			if (m >> lane & 1) result.push_back(v);
+		}
+		return result;
+	}
+	
+	private:
+	
+	Graph::vertexID root;
+	
+	std::array<lanes, Graph::numVertices> induced, fullAxis, forbidden;
+	
+	// Every call to add, in order.
+	std::vector<std::pair<Graph::storedID, lanes>> events;
+};
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef PLAYOUT_POLICY_HPP
+#define PLAYOUT_POLICY_HPP
+
+#include "graph.hpp"
+#include "subTree.hpp"
+#include "storedTree.hpp"
+
+#include <array>
+#include <random>
+#include <algorithm>
+
+/*
+A playoutPolicy biases which vertex a playout adds next. Each candidate gets
+an integer score from a few cheap features, each multiplied by a weight, and
+is chosen with probability proportional to 2^score. With every weight zero,
+the choice is uniform.
+
+Sampling is by rejection: a candidate drawn uniformly is accepted with
+probability 2^(score - highest()), so scores never need to be stored or
+updated as the tree grows.
+*/
+
+struct playoutPolicy
+{
+	constexpr static int MAX_SCORE = 6;
+	
+	// Score of a vertex with every feature zero.
+	constexpr static int BASE_SCORE = MAX_SCORE / 2;
+	
+	// Per empty neighbor that adding the vertex would make unusable.
+	int blocked = 0;
+	
+	// Per step from the outer shell.
+	int depth = 0;
+	
+	// If the vertex is in the pattern.
+	int pattern = 0;
+	
+	// Marks the vertices of a tree tiled over the whole lattice.
+	std::array<bool, Graph::numVertices> inPattern {};
+	
+	[[nodiscard]] bool uniform() const { return blocked == 0 && depth == 0 && pattern == 0; }
+	
+	// Tiles motif over the lattice, which must have the same number of dimensions.
+	// Returns false if it does not.
+	bool setPattern(const StoredTree& motif)
+	{
+		if (motif.dims.size() != Graph::dim_array.size()) return false;
+		
+		for (Graph::vertexID x = 0; x < Graph::numVertices; ++x)
+		{
+			unsigned i = 0, stride = 1;
+			for (unsigned d = 0; d < motif.dims.size(); ++d)
+			{
+				i += Graph::get_coord(d,x) % motif.dims[d] * stride;
+				stride *= motif.dims[d];
+			}
+			inPattern[x] = motif.induced[i];
+		}
+		return true;
+	}
+	
+	// Returns the score of adding x to S, which must be valid.
+	[[nodiscard]] int score(const Subtree& S, Graph::vertexID x) const
+	{
+		int s = BASE_SCORE;
+		
+		if (blocked != 0)
+		{
+			// Neighbors other than the parent that already touch the tree.
+			int numBlocked = 0;
+			for (Graph::vertexID y : Graph::vertices[x].neighbors)
+			{
+				numBlocked += !S.has(y) && S.cnt(y) != 0;
+			}
+			s += blocked * numBlocked;
+		}
+		
+		if (depth != 0) s += depth * depths[x];
+		
+		if (pattern != 0 && inPattern[x]) s += pattern;
+		
+		return std::clamp(s, 0, MAX_SCORE);
+	}
+	
+	// Returns the largest score any vertex could have.
+	[[nodiscard]] int highest() const
+	{
+		int numNeighbors = Graph::dim_array.size() * 2;
+		
+		return std::clamp(BASE_SCORE + std::max(0, blocked * (numNeighbors - 1)) +
+			std::max(0, depth * maxDepth) + std::max(0, pattern), 0, MAX_SCORE);
+	}
+	
+	// Returns true with probability 2^(score - highest()).
+	template<class URBG>
+	[[nodiscard]] bool accept(const Subtree& S, Graph::vertexID x, URBG& g) const
+	{
+		if (uniform()) return true;
+		
+		return (g() & ((1u << (highest() - score(S,x))) - 1)) == 0;
+	}
+	
+	private:
+	
+	// The number of steps from each vertex to the outer shell.
+	constexpr static auto depths = []
+	{
+		std::array<uint_least8_t, Graph::numVertices> result {};
+		
+		for (Graph::vertexID x = 0; x < Graph::numVertices; ++x)
+		{
+			Graph::vertexID nearest = Graph::numVertices;
+			for (unsigned d = 0; d < Graph::dim_array.size(); ++d)
+			{
+				Graph::vertexID c = Graph::get_coord(d,x);
+				nearest = std::min({ nearest, c, Graph::vertexID(Graph::dim_array[d] - 1 - c) });
+			}
+			result[x] = nearest;
+		}
+		return result;
+	}();
+	
+	constexpr static int maxDepth = *std::max_element(depths.begin(), depths.end());
+};
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef RANDOM_SET_HPP
+#define RANDOM_SET_HPP
+
+#include "minFastType.hpp"
+
+#include <array>
+#include <limits>
+#include <random>
+
+/*
+A randomSet is a set of integers 0-N (excluding N) stored densely,
+with a position index. Insertion, removal, membership and choosing
+a uniformly random element are all constant time, but the order of
+the elements is not preserved.
+
+T is the type used for indexing.
+*/
+
+template<class T, T N>
+class randomSet
+{
+	using stored = typename minFastType<N>::least;
+	
+	constexpr static stored EMPTY = std::numeric_limits<stored>::max();
+	
+	public:
+	
+	[[nodiscard]] constexpr randomSet() : numItems(0)
+	{
+		position.fill(EMPTY);
+	}
+	
+	// Returns true if x was inserted, false if it already existed here.
+	constexpr bool insert(T x)
+	{
+		if (position[x] != EMPTY) return false;
+		
+		position[x] = numItems;
+		items[numItems++] = x;
+		return true;
+	}
+	
+	// Returns true if x was removed, false if it did not already exist here.
+	constexpr bool erase(T x)
+	{
+		if (position[x] == EMPTY) return false;
+		
+		// Move the last item into the hole
+		stored last = items[--numItems];
+		items[position[x]] = last;
+		position[last] = position[x];
+		position[x] = EMPTY;
+		return true;
+	}
+	
+	[[nodiscard]] constexpr bool exists(T x) const { return position[x] != EMPTY; }
+	
+	[[nodiscard]] constexpr bool empty() const { return numItems == 0; }
+	
+	[[nodiscard]] constexpr T size() const { return numItems; }
+	
+	constexpr void clear()
+	{
+		for (T i = 0; i < numItems; ++i) position[items[i]] = EMPTY;
+		numItems = 0;
+	}
+	
+	// Returns a uniformly distributed item, without removing it.
+	// Assumes the set is not empty.
+	template<class URBG>
+	[[nodiscard]] T random(URBG& g) const
+	{
+		return items[std::uniform_int_distribution<uintmax_t>(0, numItems - 1)(g)];
+	}
+	
+	[[nodiscard]] constexpr auto begin() const { return items.begin(); }
+	[[nodiscard]] constexpr auto end  () const { return items.begin() + numItems; }
+	
+	private:
+	
+	stored numItems;
+	
+	std::array<stored, N> items;
+	std::array<stored, N> position;
+};
+
+#endif
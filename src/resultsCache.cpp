@@ -0,0 +1,110 @@
+#include "resultsCache.hpp"
+
+#include <algorithm>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+// Returns the file an entry with the given dimensions is stored in.
+static fs::path entryPath(const std::vector<unsigned>& dims)
+{
+	std::string name;
+	for (unsigned d : resultsCache::canonical(dims))
+	{
+		if (!name.empty()) name += '_';
+		name += std::to_string(d);
+	}
+	return fs::path(resultsCache::directory) / (name + ".txt");
+}
+
+std::vector<unsigned> resultsCache::canonical(std::vector<unsigned> dims)
+{
+	// Trailing dimensions of length 1 do not change the shape.
+	std::sort(dims.begin(), dims.end(), std::greater<unsigned>());
+	while (dims.size() > 1 && dims.back() == 1) dims.pop_back();
+	return dims;
+}
+
+bool resultsCache::fits(const std::vector<unsigned>& inner,
+	const std::vector<unsigned>& outer)
+{
+	auto a = canonical(inner), b = canonical(outer);
+	
+	if (a.size() > b.size()) return false;
+	
+	// Pairing largest with largest is optimal.
+	for (unsigned d = 0; d < a.size(); ++d)
+	{
+		if (a[d] > b[d]) return false;
+	}
+	return true;
+}
+
+std::vector<StoredTree> resultsCache::entries()
+{
+	std::vector<StoredTree> result;
+	
+	std::error_code ec;
+	for (const auto& file : fs::directory_iterator(directory, ec))
+	{
+		StoredTree t;
+		if (t.readFromFile(file.path())) result.push_back(std::move(t));
+	}
+	
+	return result;
+}
+
+std::optional<StoredTree> resultsCache::lookup(const std::vector<unsigned>& dims)
+{
+	StoredTree t;
+	if (t.readFromFile(entryPath(dims)) && canonical(t.dims) == canonical(dims))
+		return t;
+	return std::nullopt;
+}
+
+std::optional<StoredTree> resultsCache::lowerBound(const std::vector<unsigned>& dims,
+	const std::vector<StoredTree>& cached)
+{
+	std::optional<StoredTree> best;
+	
+	for (const StoredTree& t : cached)
+	{
+		StoredTree embedded;
+		if ((!best || t.numInduced > best->numInduced) && t.embed(dims, embedded))
+		{
+			best = std::move(embedded);
+		}
+	}
+	
+	return best;
+}
+
+unsigned resultsCache::upperBound(const std::vector<unsigned>& dims,
+	const std::vector<StoredTree>& cached)
+{
+	unsigned best = StoredTree(dims).numVertices();
+	
+	for (const StoredTree& t : cached)
+	{
+		if (t.exact && t.numInduced < best && fits(dims, t.dims))
+			best = t.numInduced;
+	}
+	
+	return best;
+}
+
+void resultsCache::store(const StoredTree& t)
+{
+	auto old = lookup(t.dims);
+	
+	if (old && (old->numInduced > t.numInduced ||
+		(old->numInduced == t.numInduced && (old->exact || !t.exact))))
+	{
+		return;
+	}
+	
+	std::error_code ec;
+	fs::create_directories(directory, ec);
+	
+	t.writeToFile(entryPath(t.dims));
+}
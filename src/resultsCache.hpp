@@ -0,0 +1,51 @@
+#ifndef RESULTS_CACHE_HPP
+#define RESULTS_CACHE_HPP
+
+#include "storedTree.hpp"
+
+#include <string>
+#include <vector>
+#include <optional>
+
+// A persistent, on-disk store of the best trees found for each lattice shape.
+// Entries are keyed by their dimensions in sorted order, so a 4x3x4 result
+// is shared with 3x4x4 and 4x4x3.
+
+namespace resultsCache
+{
+	// Directory holding one file per shape.
+	inline std::string directory = "results/cache";
+	
+	// Returns dims in the order used for the key.
+	[[nodiscard]] std::vector<unsigned> canonical(std::vector<unsigned> dims);
+	
+	// Returns true iff a box with dimensions inner fits inside one with
+	// dimensions outer, in some orientation.
+	[[nodiscard]] bool fits(const std::vector<unsigned>& inner,
+		const std::vector<unsigned>& outer);
+	
+	// Returns every entry in the cache.
+	[[nodiscard]] std::vector<StoredTree> entries();
+	
+	// Returns the entry for exactly this shape, if there is one.
+	[[nodiscard]] std::optional<StoredTree> lookup(const std::vector<unsigned>& dims);
+	
+	// The bounds below read every entry. Callers taking several bounds
+	// can read the entries once and pass them as cached instead.
+	
+	// Returns the largest cached tree that fits in dims, embedded in
+	// the orientation of dims. This is a lower bound for dims.
+	[[nodiscard]] std::optional<StoredTree> lowerBound(const std::vector<unsigned>& dims,
+		const std::vector<StoredTree>& cached = entries());
+	
+	// Returns the smallest exact result of any cached shape that dims fits
+	// in, or the number of vertices in dims if there is none.
+	[[nodiscard]] unsigned upperBound(const std::vector<unsigned>& dims,
+		const std::vector<StoredTree>& cached = entries());
+	
+	// Stores t if it is larger than the cached entry for its shape,
+	// or if it is the same size but now known to be exact.
+	void store(const StoredTree& t);
+}
+
+#endif
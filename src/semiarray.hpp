@@ -5,12 +5,14 @@
 A semi-array is a constexpr partially filled std::array.
 */
 
+#include "minFastType.hpp"
+
 #include <array>
 
 template<class T, std::size_t N>
 class semiarray : public std::array<T,N>
 {
-	std::size_t _size;
+	typename minFastType<N>::least _size;
 	
 	public:
 	
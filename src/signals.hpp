@@ -0,0 +1,39 @@
+#ifndef SIGNALS_HPP
+#define SIGNALS_HPP
+
+#include <atomic>
+#include <csignal>
+
+// Set from signal handlers: SIGUSR1 asks for a status report, and SIGINT
+// or SIGTERM for the search to wind down and save what it has found.
+// Searches poll these, and a second SIGINT or SIGTERM kills the program.
+// Kept apart from defs so that searches on runtime lattices can use them.
+
+namespace signals
+{
+	inline std::atomic<bool> statusRequested = false, stopRequested = false;
+	
+	void installSignalHandlers();
+}
+
+extern "C" inline void onSignal(int signal)
+{
+	if (signal == SIGUSR1)
+	{
+		signals::statusRequested = true;
+		return;
+	}
+	
+	// Only ask once, and let a second signal end the program.
+	signals::stopRequested = true;
+	std::signal(signal, SIG_DFL);
+}
+
+inline void signals::installSignalHandlers()
+{
+	std::signal(SIGUSR1, onSignal);
+	std::signal(SIGINT, onSignal);
+	std::signal(SIGTERM, onSignal);
+}
+
+#endif
@@ -0,0 +1,244 @@
+#include "storedTree.hpp"
+
+#include <cctype>
+#include <cstdint>
+#include <fstream>
+#include <numeric>
+#include <algorithm>
+#include <functional>
+
+// These are used to print to the file
+#define BLOCK_PRESENT 'X'
+#define BLOCK_MISSING '_'
+
+#define EXACT_MARKER "exact"
+
+// A stream slot for the first dimension of the next tree's header, plus one,
+// when read has already taken it while looking for a count.
+static const int pendingDim = std::ios_base::xalloc();
+
+StoredTree::StoredTree(const std::vector<unsigned>& ds) : dims(ds),
+	induced(std::accumulate(ds.begin(), ds.end(), 1u, std::multiplies<unsigned>())),
+	numInduced(0), exact(false) {}
+
+bool StoredTree::read(std::istream& stream)
+{
+	dims.clear();
+	
+	if (stream.iword(pendingDim) != 0)
+	{
+		dims.push_back(stream.iword(pendingDim) - 1);
+		stream.iword(pendingDim) = 0;
+	}
+	
+	// The first line holds the dimensions
+	stream >> std::ws;
+	for (int c; (c = stream.peek()) != '\n' && stream;)
+	{
+		if ('0' <= c && c <= '9')
+		{
+			unsigned& value = dims.emplace_back();
+			stream >> value;
+		}
+		else stream.ignore();
+	}
+	
+	if (dims.empty() || !stream) return false;
+	
+	*this = StoredTree(dims);
+	
+	char symbol;
+	for (unsigned i = 0; i < numVertices(); ++i)
+	{
+		if (!(stream >> symbol)) return false;
+		
+		if (symbol == BLOCK_PRESENT) add(i);
+		else if (symbol != BLOCK_MISSING) return false;
+	}
+	
+	// The trailing count is optional, but should agree if present. It is
+	// alone on its line, while the header of a following tree has more than
+	// one dimension, so a number followed by another on the same line is
+	// that header, and is left for the next read.
+	stream >> std::ws;
+	if (unsigned count; std::isdigit(stream.peek()) && stream >> count)
+	{
+		while (stream.peek() == ' ' || stream.peek() == '\t') stream.ignore();
+		
+		if (std::isdigit(stream.peek()))
+		{
+			stream.iword(pendingDim) = count + 1;
+			return true;
+		}
+		
+		if (count != numInduced) return false;
+	}
+	
+	// Stop here at the end of the input, or at the start of the next tree.
+	stream.clear(stream.rdstate() & std::ios::eofbit);
+	stream >> std::ws;
+	
+	std::string marker;
+	exact = (stream.peek() == EXACT_MARKER[0] && stream >> marker && marker == EXACT_MARKER);
+	
+	stream.clear(stream.rdstate() & std::ios::eofbit);
+	
+	return true;
+}
+
+bool StoredTree::readFromFile(const std::string& filename)
+{
+	std::ifstream file(filename);
+	return file && read(file);
+}
+
+void StoredTree::write(std::ostream& stream) const
+{
+	for (unsigned d : dims)
+	{
+		stream << d << ' ';
+	}
+	stream << "\n\n";
+	
+	// If 2 or 3 dimensions, print in a readable format.
+	// Otherwise, just print all on one line.
+	unsigned x = 0;
+	if (dims.size() == 3)
+	{
+		for (unsigned i = 0; i < dims[0]; ++i)
+		{
+			for (unsigned j = 0; j < dims[1]; ++j)
+			{
+				for (unsigned k = 0; k < dims[2]; ++k)
+				{
+					stream << (induced[x++] ? BLOCK_PRESENT : BLOCK_MISSING);
+				}
+				stream << '\n';
+			}
+			stream << '\n';
+		}
+	}
+	else if (dims.size() == 2)
+	{
+		for (unsigned i = 0; i < dims[0]; ++i)
+		{
+			for (unsigned j = 0; j < dims[1]; ++j)
+			{
+				stream << (induced[x++] ? BLOCK_PRESENT : BLOCK_MISSING);
+			}
+			stream << '\n';
+		}
+		stream << '\n';
+	}
+	else
+	{
+		for (; x < numVertices(); ++x)
+		{
+			stream << (induced[x] ? BLOCK_PRESENT : BLOCK_MISSING);
+		}
+		stream << "\n\n";
+	}
+	
+	stream << numInduced << std::endl;
+	
+	if (exact) stream << EXACT_MARKER << std::endl;
+}
+
+void StoredTree::writeToFile(const std::string& filename) const
+{
+	std::ofstream file(filename);
+	write(file);
+}
+
+bool StoredTree::readBinary(std::istream& stream)
+{
+	std::uint32_t numDims;
+	if (!stream.read(reinterpret_cast<char*>(&numDims), sizeof(numDims)) || numDims == 0)
+		return false;
+	
+	std::vector<std::uint32_t> ds(numDims);
+	if (!stream.read(reinterpret_cast<char*>(ds.data()), numDims * sizeof(std::uint32_t)))
+		return false;
+	
+	*this = StoredTree({ ds.begin(), ds.end() });
+	
+	std::vector<char> bytes((numVertices() + 7) / 8);
+	if (!stream.read(bytes.data(), bytes.size())) return false;
+	
+	for (unsigned i = 0; i < numVertices(); ++i)
+	{
+		if (bytes[i / 8] >> (i % 8) & 1) add(i);
+	}
+	
+	return true;
+}
+
+void StoredTree::writeBinary(std::ostream& stream) const
+{
+	std::uint32_t numDims = dims.size();
+	stream.write(reinterpret_cast<const char*>(&numDims), sizeof(numDims));
+	
+	for (std::uint32_t d : dims)
+	{
+		stream.write(reinterpret_cast<const char*>(&d), sizeof(d));
+	}
+	
+	std::vector<char> bytes((numVertices() + 7) / 8);
+	for (unsigned i = 0; i < numVertices(); ++i)
+	{
+		if (induced[i]) bytes[i / 8] |= 1 << (i % 8);
+	}
+	stream.write(bytes.data(), bytes.size());
+}
+
+bool StoredTree::embed(const std::vector<unsigned>& ds, StoredTree& result) const
+{
+	if (dims.size() > ds.size()) return false;
+	
+	// Missing dimensions are treated as having length 1.
+	std::vector<unsigned> padded(dims);
+	padded.resize(ds.size(), 1);
+	
+	// axis[d] is the dimension of ds that dimension d of this tree maps to.
+	std::vector<unsigned> axis(ds.size());
+	std::iota(axis.begin(), axis.end(), 0);
+	
+	do
+	{
+		bool fits = true;
+		for (unsigned d = 0; d < ds.size(); ++d)
+		{
+			if (padded[d] > ds[axis[d]]) fits = false;
+		}
+		if (!fits) continue;
+		
+		std::vector<unsigned> strides(ds.size(), 1);
+		for (unsigned d = 1; d < ds.size(); ++d)
+		{
+			strides[d] = strides[d - 1] * ds[d - 1];
+		}
+		
+		result = StoredTree(ds);
+		
+		for (unsigned i = 0; i < numVertices(); ++i)
+		{
+			if (!induced[i]) continue;
+			
+			unsigned rest = i, target = 0;
+			for (unsigned d = 0; d < ds.size(); ++d)
+			{
+				target += (rest % padded[d]) * strides[axis[d]];
+				rest /= padded[d];
+			}
+			result.add(target);
+		}
+		
+		// Only an exact result for the same shape stays exact.
+		result.exact = exact && numVertices() == result.numVertices();
+		
+		return true;
+	}
+	while (std::next_permutation(axis.begin(), axis.end()));
+	
+	return false;
+}
@@ -0,0 +1,52 @@
+#ifndef STORED_TREE_HPP
+#define STORED_TREE_HPP
+
+#include <vector>
+#include <string>
+#include <istream>
+#include <ostream>
+
+/*
+A StoredTree is a tree as it appears in a result file, independent of the
+lattice size the program was compiled for. Vertices are numbered the same
+way as in Graph, with dimension 0 varying fastest.
+*/
+
+struct StoredTree
+{
+	std::vector<unsigned> dims;
+	std::vector<bool> induced;
+	
+	unsigned numInduced;
+	
+	// True iff numInduced is known to be the largest possible for dims.
+	bool exact;
+	
+	StoredTree() : numInduced(0), exact(false) {}
+	StoredTree(const std::vector<unsigned>& ds);
+	
+	[[nodiscard]] unsigned numVertices() const { return induced.size(); }
+	
+	void add(unsigned i) { if (!induced[i]) { induced[i] = true; ++numInduced; } }
+	
+	// Reads a tree in the X/_ format produced by write. Returns
+	// false if the input is malformed. Trees written by write can be
+	// concatenated and read back one at a time.
+	bool read(std::istream&);
+	bool readFromFile(const std::string& filename);
+	
+	void write(std::ostream&) const;
+	void writeToFile(const std::string& filename) const;
+	
+	// A compact binary format: the number of dimensions, each dimension,
+	// then one bit per vertex, packed into bytes from the lowest bit.
+	// Integers are 32 bits in native byte order.
+	bool readBinary(std::istream&);
+	void writeBinary(std::ostream&) const;
+	
+	// Places this tree in the corner of a lattice with dimensions ds,
+	// permuting the axes if needed. Returns false if it does not fit.
+	bool embed(const std::vector<unsigned>& ds, StoredTree& result) const;
+};
+
+#endif
@@ -1,58 +1,8 @@
 #include "graph.hpp"
 #include "subTree.hpp"
 
-#include <fstream>
 #include <queue>
 
-// These are used to print to the file
-#define BLOCK_PRESENT 'X'
-#define BLOCK_MISSING '_'
-
-bool Subtree::add(Graph::vertexID i)
-{
-	vertices[i].induced = true;
-	
-	// This should have one neighbor, we need to validate the neighbor
-	for (const Graph::vertexID x : Graph::vertices[i].neighbors)
-	{
-		if (has(x))
-		{
-			++vertices[x].effectiveDegree;
-			
-			if (validate(x)) break;
-			else
-			{
-				// Undo changes made and report that this is invalid
-				--vertices[x].effectiveDegree;
-				vertices[i].induced = false;
-				return false;
-			}
-		}
-	}
-	
-	++numInduced;
-
-	for (const Graph::vertexID x : Graph::vertices[i].neighbors)
-	{
-		// Ignore the induced vertex, its degree has already been increased.
-		if (!has(x))
-			++vertices[x].effectiveDegree;
-	}
-	return true;
-}
-
-void Subtree::rem(Graph::vertexID i)
-{
-	vertices[i].induced = false;
-	
-	--numInduced;
-	
-	for (const Graph::vertexID x : Graph::vertices[i].neighbors)
-	{
-		--vertices[x].effectiveDegree;
-	}
-}
-
 void Subtree::print() const
 {
 	std::cout << "Subgraph: ";
@@ -65,80 +15,26 @@ void Subtree::print() const
 
 void Subtree::writeToFile(std::string filename) const
 {
-	std::ofstream file(filename);
-	
-	for (unsigned d : dim_array)
-	{
-		file << d << ' ';
-	}
-	file << "\n\n";
+	toStored().writeToFile(filename);
+}
+
+StoredTree Subtree::toStored() const
+{
+	StoredTree result({ dim_array.begin(), dim_array.end() });
 	
-	// If 2 or 3 dimensions, print in a readable format.
-	// Otherwise, just print all on one line.
-	if constexpr (dim_array.size() == 3)
-	{
-		Graph::vertexID x = 0;
-		for (unsigned i = 0; i < dim_array[0]; ++i)
-		{
-			for (unsigned j = 0; j < dim_array[1]; ++j)
-			{
-				for (unsigned k = 0; k < dim_array[2]; ++k)
-				{
-					file << (has(x++) ? BLOCK_PRESENT : BLOCK_MISSING);
-				}
-				file << '\n';
-			}
-			file << '\n';
-		}
-	}
-	else if constexpr (dim_array.size() == 2)
-	{
-		Graph::vertexID x = 0;
-		for (unsigned i = 0; i < dim_array[0]; ++i)
-		{
-			for (unsigned j = 0; j < dim_array[1]; ++j)
-			{
-				file << (has(x++) ? BLOCK_PRESENT : BLOCK_MISSING);
-			}
-			file << '\n';
-		}
-		file << '\n';
-	}
-	else
+	for (Graph::vertexID x = 0; x < Graph::numVertices; ++x)
 	{
-		for (Graph::vertexID x = 0; x < Graph::numVertices; ++x)
-		{
-			file << (has(x) ? BLOCK_PRESENT : BLOCK_MISSING);
-		}
-		file << "\n\n";
+		if (has(x)) result.add(Graph::position(x));
 	}
 	
-	file << numInduced << std::endl;
+	return result;
 }
 
-Subtree::Subtree(Graph::vertexID r) : numInduced(0), root(r), vertices()
+Subtree::Subtree(Graph::vertexID r) : numInduced(0), root(r), hash(0), vertices()
 {
 	add(r);
 }
 
-bool Subtree::validate(Graph::vertexID i) const
-	// TODO: Requires dimension 2 or 3, use
-	// if constexpr for different versions
-{
-	if (cnt(i) != 4) return cnt(i) < 4;
-	
-	auto& dirs = Graph::vertices[i].directions;
-	
-	// Ensure all axis have at least one neighbor
-	for (unsigned d = 0; d < 3; ++d)
-	{
-		// 5 - d gets the opposite direction
-		if (!exists(dirs[d]) && !exists(dirs[5 - d]))
-			return false;
-	}
-	return true;	
-}
-
 bool Subtree::hasEnclosedSpace() const
 {
 	// enum to mark each vertex
@@ -192,27 +88,3 @@ bool Subtree::hasEnclosedSpace() const
 	// be vertices not accounted for in this formula
 	return numInduced + numConnected != Graph::numVertices;
 }
-
-bool Subtree::safeToAdd(Graph::vertexID i)
-{
-	vertices[i].induced = true;
-	
-	// This should have one neighbor, we need to validate the neighbor
-	for (const Graph::vertexID x : Graph::vertices[i].neighbors)
-	{
-		if (has(x))
-		{
-			++vertices[x].effectiveDegree;
-			
-			bool result = validate(x);
-			
-			// Undo changes made and report that this is invalid
-			--vertices[x].effectiveDegree;
-			vertices[i].induced = false;
-			
-			return result;
-		}
-	}
-	
-	return false;
-}
@@ -2,9 +2,13 @@
 #define SUBTREE_HPP
 
 #include "graph.hpp"
+#include "minFastType.hpp"
+#include "storedTree.hpp"
 
+#include <bit>
 #include <array>
 #include <vector>
+#include <cstdint>
 #include <iostream>
 
 // Represents an induced subtree
@@ -15,29 +19,105 @@ struct Subtree
 	// To be removed later, used as a stopgap solution before templatization
 	static constexpr auto dim_array = std::to_array<unsigned>({ SIZE });
 	
+	static constexpr unsigned numDirections = dim_array.size() * 2;
+	
 	public:
 	
+	// Bit k is set iff the neighbor in direction k (as in
+	// Graph::graphVertex::directions) is induced.
+	using neighborMask = minFastType<(uintmax_t(1) << numDirections) - 1>::least;
+	
 	struct subTreeVertex
 	{
 		bool induced;
-		unsigned effectiveDegree;
+		neighborMask neighbors;
 		
-		subTreeVertex() : induced(false), effectiveDegree(0) {}
+		subTreeVertex() : induced(false), neighbors(0) {}
 	};
 	
-	// Each index is either enabled or disabled, and includes its
-	// effective degree (which is cnt)
+	private:
+	
+	// Direction k and direction numDirections - 1 - k lie on the same axis.
+	static constexpr unsigned opposite(unsigned k) { return numDirections - 1 - k; }
+	
+	// The neighbor condition for every mask: at most one axis may have
+	// both of its neighbors induced.
+	static constexpr auto allowed = []
+	{
+		std::array<bool, size_t(1) << numDirections> table {};
+		
+		for (size_t mask = 0; mask < table.size(); ++mask)
+		{
+			unsigned fullAxes = 0;
+			for (unsigned d = 0; d < dim_array.size(); ++d)
+			{
+				fullAxes += (mask >> d & 1) && (mask >> (numDirections - 1 - d) & 1);
+			}
+			table[mask] = fullAxes <= 1;
+		}
+		return table;
+	}();
+	
+	// The number of induced neighbors for every mask, since std::popcount
+	// is not a single instruction on every target.
+	static constexpr auto degree = []
+	{
+		std::array<uint_least8_t, size_t(1) << numDirections> table {};
+		
+		for (size_t mask = 1; mask < table.size(); ++mask)
+		{
+			table[mask] = table[mask & (mask - 1)] + 1;
+		}
+		return table;
+	}();
+	
+	// A random key for each vertex. A tree's hash is the xor of the keys
+	// of its vertices, so it depends only on which vertices it has.
+	static constexpr auto zobrist = []
+	{
+		std::array<uint64_t, Graph::numVertices> keys {};
+		
+		// splitmix64
+		uint64_t state = 0;
+		for (uint64_t& key : keys)
+		{
+			uint64_t z = (state += 0x9E3779B97F4A7C15);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+			key = z ^ (z >> 31);
+		}
+		return keys;
+	}();
+	
+	// Returns true iff the first induced neighbor of i would still
+	// satisfy the neighbor condition with i added.
+	bool fits(Graph::vertexID i) const
+	{
+		unsigned k = std::countr_zero(vertices[i].neighbors);
+		Graph::vertexID x = Graph::vertices[i].directions[k];
+		return allowed[vertices[x].neighbors | neighborMask(1) << opposite(k)];
+	}
+	
+	public:
+	
+	// Each index is either enabled or disabled, and includes
+	// which of its neighbors are induced (cnt is their number)
 	
 	unsigned numInduced;
 	
+	// Searches never add a vertex below the root, so the enumeration
+	// finds each tree only from its smallest vertex.
 	Graph::vertexID root;
 	
+	// Kept up to date by add and rem, see zobrist.
+	uint64_t hash;
+	
 	std::array<subTreeVertex, Graph::numVertices> vertices;
 	
 	Subtree(Graph::vertexID);
 	
-	unsigned cnt(Graph::vertexID i) const { return vertices[i].effectiveDegree; }
-	bool     has(Graph::vertexID i) const { return vertices[i].induced;         }
+	unsigned cnt(Graph::vertexID i) const { return degree[vertices[i].neighbors]; }
+	bool     has(Graph::vertexID i) const { return vertices[i].induced; }
 	
 	// Does nothing if the graph would be invalidated
 	bool add(Graph::vertexID);
@@ -51,16 +131,115 @@ struct Subtree
 	
 	void writeToFile(std::string filename) const;
 	
-	// Defined only for dimensions 2 and 3. A vertex is valid
-	// if it has at most one axis with both neighbors.
-	bool validate(Graph::vertexID i) const;
+	// Returns a copy of this tree that can be written or cached.
+	StoredTree toStored() const;
+	
+	// A vertex is valid if it has at most one axis with both neighbors.
+	bool validate(Graph::vertexID i) const { return allowed[vertices[i].neighbors]; }
 	
 	// Returns true iff there is at least one block whose
 	// faces cannot be accessed externally.
 	bool hasEnclosedSpace() const;
 	
+	// Returns true iff i, which has just been added, cut some empty vertex
+	// off from the outer shell. Assuming there was no enclosed space before,
+	// only empty neighbors of i can have been cut off. Searches only add
+	// vertices, so enclosed space is never joined back to the shell, only
+	// filled. Filling it is impossible too: the last empty vertex of the
+	// space would have every neighbor induced, which breaks the neighbor
+	// condition. So any tree containing this one has enclosed space too.
+	bool enclosesSpace(Graph::vertexID i) const;
+	
 	// Returns true iff adding i would preserve the neighbor condition.
-	bool safeToAdd(Graph::vertexID);
+	bool safeToAdd(Graph::vertexID i) const
+		{ return vertices[i].neighbors != 0 && fits(i); }
 };
 
+// Modifying and checking vertices happens at every node of the search,
+// so these live in the header where the callers can inline them.
+
+inline bool Subtree::add(Graph::vertexID i)
+{
+	// This should have one neighbor, we need to validate the neighbor.
+	// Only the root has none.
+	if (vertices[i].neighbors != 0 && !fits(i)) return false;
+	
+	vertices[i].induced = true;
+	
+	++numInduced;
+	hash ^= zobrist[i];
+	
+	auto& dirs = Graph::vertices[i].directions;
+	for (unsigned k = 0; k < numDirections; ++k)
+	{
+		if (dirs[k] != Graph::EMPTY)
+			vertices[dirs[k]].neighbors |= neighborMask(1) << opposite(k);
+	}
+	return true;
+}
+
+inline void Subtree::rem(Graph::vertexID i)
+{
+	vertices[i].induced = false;
+	
+	--numInduced;
+	hash ^= zobrist[i];
+	
+	auto& dirs = Graph::vertices[i].directions;
+	for (unsigned k = 0; k < numDirections; ++k)
+	{
+		if (dirs[k] != Graph::EMPTY)
+			vertices[dirs[k]].neighbors &= ~(neighborMask(1) << opposite(k));
+	}
+}
+
+inline bool Subtree::enclosesSpace(Graph::vertexID i) const
+{
+	// Breadth-first search from each empty neighbor, stopping as soon as
+	// it reaches the shell. Each search marks vertices with its own number,
+	// so the marks never need clearing, and a vertex marked by an earlier
+	// search from this call is known to reach the shell.
+	thread_local std::array<uint32_t, Graph::numVertices> mark {};
+	thread_local std::array<Graph::storedID, Graph::numVertices> queue;
+	thread_local uint32_t search = 0;
+	
+	if (search > UINT32_MAX - 2 * dim_array.size())
+	{
+		mark.fill(0);
+		search = 0;
+	}
+	
+	const uint32_t first = search + 1;
+	
+	for (Graph::vertexID y : Graph::vertices[i].neighbors)
+	{
+		// Most neighbors are on the shell, and need no search at all.
+		if (has(y) || Graph::onOuterShell(y) || mark[y] >= first) continue;
+		
+		mark[y] = ++search;
+		queue[0] = y;
+		
+		bool reached = false;
+		for (unsigned front = 0, back = 1; front < back && !reached; ++front)
+		{
+			for (Graph::vertexID z : Graph::vertices[queue[front]].neighbors)
+			{
+				if (has(z) || mark[z] == search) continue;
+				
+				if (Graph::onOuterShell(z) || mark[z] >= first)
+				{
+					reached = true;
+					break;
+				}
+				
+				mark[z] = search;
+				queue[back++] = z;
+			}
+		}
+		
+		if (!reached) return true;
+	}
+	return false;
+}
+
 #endif
@@ -0,0 +1,235 @@
+#include "frontier.hpp"
+#include "frontierSolver.hpp"
+#include "resultsCache.hpp"
+#include "signals.hpp"
+
+#include <set>
+#include <cmath>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+// Solves many shapes in one process, sharing one set of worker threads
+// between them. Each shape is solved exactly with a frontierSolver, the
+// most expensive first, so no long shape is left to run alone at the end.
+// Shapes with a wider cross-section than --max-width get the best bounds
+// that the results cache, including the shapes just solved, can give them.
+
+using clock_type = std::chrono::steady_clock;
+
+struct shape
+{
+	std::vector<unsigned> dims;
+	
+	// Frontier states grow about 3.5-fold per cell of the cross-section.
+	double cost = 0;
+	
+	bool solvable = true;
+	
+	// The result, which is a lower bound unless exact.
+	unsigned size = 0, upper = 0;
+	bool exact = false;
+	
+	std::string source;
+	float seconds = 0;
+};
+
+// Expands a shape such as 3,3-5,4 into 3,3,4 3,4,4 3,5,4, inserting each
+// shape in canonical order. Returns false if it is malformed.
+bool expand(const std::string& spec, std::set<std::vector<unsigned>>& result)
+{
+	std::vector<std::pair<unsigned, unsigned>> ranges;
+	
+	std::stringstream sides(spec);
+	for (std::string side; std::getline(sides, side, ',');)
+	{
+		size_t dash = side.find('-');
+		try
+		{
+			unsigned low = std::stoi(side.substr(0, dash));
+			unsigned high = (dash == std::string::npos) ? low : std::stoi(side.substr(dash + 1));
+			if (low == 0 || high < low) return false;
+			
+			ranges.push_back({ low, high });
+		}
+		catch (const std::exception&) { return false; }
+	}
+	
+	if (ranges.empty() || ranges.size() > frontier::MAX_DIMENSIONS) return false;
+	
+	std::vector<unsigned> dims;
+	for (auto [low, high] : ranges) dims.push_back(low);
+	
+	while (true)
+	{
+		result.insert(resultsCache::canonical(dims));
+		
+		// Counts through every combination, like an odometer.
+		unsigned d = 0;
+		for (; d < dims.size() && dims[d] == ranges[d].second; ++d) dims[d] = ranges[d].first;
+		
+		if (d == dims.size()) return true;
+		++dims[d];
+	}
+}
+
+void solve(shape& s)
+{
+	auto start = clock_type::now();
+	
+	const frontier::orientation o(s.dims);
+	
+	frontierSolver solver(o.swept, false);
+	solver.verbose = false;
+	
+	s.size = solver.solve();
+	s.seconds = std::chrono::duration<float>(clock_type::now() - start).count();
+	
+	// A stopped solve leaves a lower bound, which is bounded again later.
+	if (solver.stopped) s.source = "stopped";
+	else
+	{
+		s.upper = s.size;
+		s.exact = true;
+		s.source = "solved";
+	}
+	
+	StoredTree best = o.unsweep(solver.induced);
+	best.exact = s.exact;
+	
+	if (s.size != 0) resultsCache::store(best);
+}
+
+int main(int num_args, char** args)
+{
+	std::vector<std::string> options(args + 1, args + num_args);
+	
+	// Wider cross-sections need more memory than a typical machine has.
+	unsigned maxWidth = 12;
+	
+	bool valid = true;
+	if (options.size() >= 2 && options[options.size() - 2] == "--max-width")
+	{
+		try { maxWidth = std::min<unsigned>(std::stoi(options.back()), frontier::MAX_WIDTH); }
+		catch (const std::exception&) { valid = false; }
+		
+		options.resize(options.size() - 2);
+	}
+	
+	std::set<std::vector<unsigned>> dimsList;
+	
+	valid &= options.size() >= 2;
+	for (unsigned i = 1; i < options.size() && valid; ++i) valid = expand(options[i], dimsList);
+	
+	if (!valid)
+	{
+		std::cerr << "usage: " << args[0] << " <table> <shape>... [--max-width W], where a"
+			" shape is A,B,C,... and any side can be a range such as 3-6" << std::endl;
+		exit(1);
+	}
+	
+	std::vector<shape> shapes;
+	for (const auto& dims : dimsList)
+	{
+		shape& s = shapes.emplace_back();
+		s.dims = dims;
+		
+		const frontier::orientation o(dims);
+		unsigned width = o.swept.numVertices() / o.swept.dims.back();
+		
+		s.cost = o.swept.numVertices() * std::pow(3.5, width);
+		s.solvable = width <= maxWidth;
+		
+		if (auto cached = resultsCache::lookup(dims); cached && cached->exact)
+		{
+			s.size = s.upper = cached->numInduced;
+			s.exact = true;
+			s.source = "cached";
+		}
+	}
+	
+	std::vector<shape*> queue;
+	for (shape& s : shapes)
+	{
+		if (s.solvable && !s.exact) queue.push_back(&s);
+	}
+	
+	std::sort(queue.begin(), queue.end(), [](shape* a, shape* b) { return a->cost > b->cost; });
+	
+	std::clog << shapes.size() << " shapes, " << queue.size() << " to solve" << std::endl;
+	
+	signals::installSignalHandlers();
+	
+	std::atomic<size_t> next = 0, numDone = 0;
+	std::mutex IOmutex;
+	
+	auto work = [&]
+	{
+		for (size_t i; !signals::stopRequested && (i = next++) < queue.size();)
+		{
+			solve(*queue[i]);
+			++numDone;
+			
+			std::lock_guard<std::mutex> lock(IOmutex);
+			
+			std::clog << queue[i]->source;
+			for (unsigned d : queue[i]->dims) std::clog << ' ' << d;
+			std::clog << ": " << queue[i]->size << " in " << queue[i]->seconds << " seconds" << std::endl;
+		}
+	};
+	
+	unsigned numThreads = std::max(1u, std::thread::hardware_concurrency());
+	std::atomic<unsigned> numRunning = numThreads;
+	
+	std::vector<std::thread> threads;
+	for (unsigned id = 0; id < numThreads; ++id)
+	{
+		threads.emplace_back([&] { work(); --numRunning; });
+	}
+	
+	while (numRunning != 0)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		
+		if (!signals::statusRequested) continue;
+		signals::statusRequested = false;
+		
+		std::lock_guard<std::mutex> lock(IOmutex);
+		std::clog << numDone << " of " << queue.size() << " shapes solved, "
+			<< std::min(next.load(), queue.size()) - numDone << " in progress" << std::endl;
+	}
+	
+	for (auto& t : threads) t.join();
+	
+	if (signals::stopRequested) std::clog << "stopped early" << std::endl;
+	
+	// Every solved shape is in the cache now, so it gives the best bounds.
+	const auto cached = resultsCache::entries();
+	for (shape& s : shapes)
+	{
+		if (s.exact) continue;
+		
+		auto lower = resultsCache::lowerBound(s.dims, cached);
+		s.size = std::max(s.size, lower ? lower->numInduced : 0);
+		s.upper = resultsCache::upperBound(s.dims, cached);
+		s.source = "bounded";
+	}
+	
+	std::ofstream file(options[0]);
+	for (std::ostream* out : { static_cast<std::ostream*>(&std::cout), static_cast<std::ostream*>(&file) })
+	{
+		*out << "shape\tlargest\tupper\tsource\tseconds" << std::endl;
+		for (const shape& s : shapes)
+		{
+			for (unsigned d = 0; d < s.dims.size(); ++d) *out << (d ? "x" : "") << s.dims[d];
+			*out << '\t' << s.size << '\t' << s.upper << '\t' << s.source << '\t' << s.seconds << std::endl;
+		}
+	}
+}
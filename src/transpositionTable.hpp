@@ -0,0 +1,109 @@
+#ifndef TRANSPOSITION_TABLE_HPP
+#define TRANSPOSITION_TABLE_HPP
+
+#include "minFastType.hpp"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+/*
+A transpositionTable maps 64-bit keys to a score and a sequence of
+integers 0-N (excluding N) of length less than N. It has a fixed number
+of slots, each holding at most one key, so a new key can replace an
+old one.
+
+Every slot has a sequence number, which is odd while the slot is being
+written. Writers that find a slot busy give up instead of waiting, and
+readers that see it change while they read report a miss, so no thread
+ever blocks another.
+
+T is the type used for indexing.
+*/
+
+template<class T, T N>
+class transpositionTable
+{
+	using stored = typename minFastType<N>::least;
+	
+	struct slot
+	{
+		std::atomic<uint32_t> sequence { 0 };
+		std::atomic<uint32_t> score { 0 };
+		std::atomic<uint64_t> key { 0 };
+		std::atomic<stored> length { 0 };
+		std::array<std::atomic<stored>, N> items;
+	};
+	
+	public:
+	
+	// Uses as many slots as fit in the given number of megabytes, rounded
+	// down to a power of two.
+	explicit transpositionTable(size_t megabytes)
+	{
+		numSlots = 1;
+		while (2 * numSlots * sizeof(slot) <= megabytes << 20) numSlots *= 2;
+		
+		slots = std::make_unique<slot[]>(numSlots);
+	}
+	
+	// If key is here, sets score, appends its sequence to list, and returns
+	// true. Empty slots have key 0, so it must not be used.
+	template<class List>
+	bool find(uint64_t key, unsigned& score, List& list) const
+	{
+		const slot& s = slots[key & (numSlots - 1)];
+		
+		uint32_t before = s.sequence.load(std::memory_order_acquire);
+		if ((before & 1) || s.key.load(std::memory_order_relaxed) != key) return false;
+		
+		std::array<stored, N> copy;
+		stored length = s.length.load(std::memory_order_relaxed);
+		for (stored i = 0; i < length; ++i) copy[i] = s.items[i].load(std::memory_order_relaxed);
+		unsigned found = s.score.load(std::memory_order_relaxed);
+		
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (s.sequence.load(std::memory_order_relaxed) != before) return false;
+		
+		score = found;
+		for (stored i = 0; i < length; ++i) list.push_back(copy[i]);
+		return true;
+	}
+	
+	// Stores the score and the sequence [begin, end) under key, unless the
+	// slot is busy or already holds key with at least this score.
+	template<class Iterator>
+	void store(uint64_t key, unsigned score, Iterator begin, Iterator end)
+	{
+		slot& s = slots[key & (numSlots - 1)];
+		
+		uint32_t before = s.sequence.load(std::memory_order_relaxed);
+		if ((before & 1) || (s.key.load(std::memory_order_relaxed) == key &&
+			s.score.load(std::memory_order_relaxed) >= score)) return;
+		
+		if (!s.sequence.compare_exchange_strong(before, before + 1, std::memory_order_relaxed))
+			return;
+		
+		// Orders the odd sequence number before the data, so a reader that
+		// sees any of the new data also sees that the slot changed.
+		std::atomic_thread_fence(std::memory_order_release);
+		
+		stored length = 0;
+		for (; begin != end; ++begin) s.items[length++].store(*begin, std::memory_order_relaxed);
+		
+		s.length.store(length, std::memory_order_relaxed);
+		s.score.store(score, std::memory_order_relaxed);
+		s.key.store(key, std::memory_order_relaxed);
+		
+		s.sequence.store(before + 2, std::memory_order_release);
+	}
+	
+	private:
+	
+	size_t numSlots;
+	
+	std::unique_ptr<slot[]> slots;
+};
+
+#endif
@@ -3,90 +3,574 @@
 #include "indexedList.hpp"
 
 #include <stack>
+#include <atomic>
+#include <cstdio>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
 #include <iostream>
 
-// Performs the bulk of the algorithm described in the paper.
-void branch(int id, Subtree& S, indexedList<Graph::vertexID, Graph::numVertices>& border,
-	std::stack<defs::action>& previous_actions)
+using borderList = indexedList<Graph::vertexID, Graph::numVertices>;
+
+// A part of the search that any thread can run, or that can be saved and
+// resumed: every tree that grows from S by adding vertices of the border.
+struct job
+{
+	Subtree S;
+	borderList border;
+	
+	// Set if S was split off from a search that had already visited it and
+	// added one of its children, so S itself is neither counted nor a candidate.
+	bool continued = false;
+};
+
+// What a level of the search needs beyond S, border and previous_actions: the
+// child it is exploring, whether it had one, and whether its siblings that
+// are still on the border are left to another job.
+struct frame
 {
-	// We only consider subtrees without children to be good candidates,
-	// since any children of this tree would be better candidates.
-	if (border.empty())
+	Graph::storedID x;
+	bool extended, last;
+};
+
+// The number of jobs pushed to the pool that have not finished.
+std::atomic<unsigned> numTasks = 0;
+
+// If open, jobs left when a stop is requested are saved here instead of dropped.
+std::ofstream checkpoint;
+
+// Runs a job in the pool.
+void pushJob(job j);
+
+// The settings that change which trees a search reports: whether it prunes
+// enclosed space, then the mask in the symbols of a mask file, by position.
+// A checkpoint only continues a search with the same settings.
+std::string searchSettings()
+{
+	std::string settings = defs::pruneEnclosed ? "1 " : "0 ";
+	for (unsigned i = 0; i < Graph::numVertices; ++i)
 	{
-		if (S.numInduced > defs::largestTree)
-		{
-			defs::checkCandidate(S);
-		}
+		Graph::vertexID x = Graph::vertexAt(i);
+		settings += defs::forced[x] ? 'X' : defs::forbidden[x] ? '#' : '_';
 	}
-	else
+	return settings;
+}
+
+// Writes j to the checkpoint as a line with whether it is continued, the
+// positions of S, a bar, and the positions of the border in order.
+void saveJob(job j)
+{
+	std::lock_guard<std::mutex> lock(defs::IOmutex);
+	
+	checkpoint << j.continued;
+	for (Graph::vertexID x = 0; x < Graph::numVertices; ++x)
+	{
+		if (j.S.has(x)) checkpoint << ' ' << unsigned(Graph::position(x));
+	}
+	
+	checkpoint << " |";
+	for (Graph::vertexID x : j.border) checkpoint << ' ' << unsigned(Graph::position(x));
+	checkpoint << std::endl;
+}
+
+// Calls visit(d,S,border) with the state of each level d from top - 1 down to
+// lowest that still has siblings to explore, where border holds just those
+// siblings. Levels are undone on copies, so the search is unchanged.
+template<class Visit>
+void forEachRemaining(int id, Subtree S, borderList border, std::stack<defs::action> previous_actions,
+	const frame* frames, unsigned top, unsigned lowest, Visit visit)
+{
+	for (unsigned d = top; d-- > lowest;)
+	{
+		defs::lists[id]->copyTo(S.numInduced,border);
+		defs::restore(border,previous_actions);
+		S.rem(frames[d].x);
+		
+		if (!frames[d].last && !border.empty()) visit(d,S,border);
+	}
+}
+
+// Performs the bulk of the algorithm described in the paper, with the
+// recursion kept in a flat array of frames, one per level above j.S. When a
+// thread is idle, the siblings left at the oldest level are split off into
+// a job of their own, since they hold the most work.
+void run(int id, job& j)
+{
+	if (defs::stopRequested.load(std::memory_order_relaxed))
 	{
-		do
+		if (checkpoint.is_open()) saveJob(j);
+		return;
+	}
+	
+	Subtree& S = j.S;
+	borderList& border = j.border;
+	std::stack<defs::action> previous_actions;
+	
+	std::vector<frame> frames(Graph::numVertices + 1 - S.numInduced);
+	unsigned top = 0;
+	
+	if (j.continued) frames[0] = { 0, true, false };
+	
+	for (bool entering = !j.continued, returning = false;;)
+	{
+		frame& f = frames[top];
+		
+		if (entering && defs::stopRequested.load(std::memory_order_relaxed))
+		{
+			// Saves what is left, then unwinds every level without
+			// exploring any more siblings.
+			if (checkpoint.is_open())
+			{
+				saveJob({ S, border });
+				forEachRemaining(id,S,border,previous_actions,frames.data(),top,0,
+					[](unsigned, const Subtree& S, const borderList& border) { saveJob({ S, border, true }); });
+			}
+			
+			for (unsigned d = 0; d <= top; ++d) frames[d].last = true;
+			f.extended = true;
+		}
+		else if (entering)
+		{
+			++defs::numNodes[id].n;
+			defs::numNodes[id].depth = S.numInduced;
+			
+			// We only consider subtrees without children to be good candidates,
+			// since any children of this tree would be better candidates.
+			if (border.empty())
+			{
+				if (S.numInduced > defs::largestTree)
+				{
+					defs::checkCandidate(S);
+				}
+				
+				if (top == 0) return;
+				
+				--top;
+				entering = false;
+				returning = true;
+				continue;
+			}
+			
+			f.extended = f.last = false;
+		}
+		else if (returning)
+		{
+			defs::restore(border,previous_actions);
+			S.rem(f.x);
+		}
+		
+		entering = returning = false;
+		
+		while (!f.last && !border.empty())
 		{
 			// Get and remove the first element
 			Graph::vertexID x = border.pop_front();
 			
 			// Push it onto a temporary list. This is a fix
 			// to the base algorithm, it will not work without this
-			// (along with the swap below)
-			defs::lists[id][S.numInduced].push_back(x);
+			// (along with the restore below)
+			defs::lists[id]->push_back(S.numInduced,x);
+			
+			// The siblings after x are set aside from it, so none of their trees
+			// can have it, and a forced vertex must be in every tree.
+			if (defs::forced[x]) f.last = true;
 			
 			// Ensure the addition would be valid
-			if(S.add(x))
+			if (!S.add(x)) continue;
+			
+			// Every tree below this one would have enclosed space too.
+			if (defs::pruneEnclosed && S.enclosesSpace(x))
 			{
-				previous_actions.push({defs::stop,0});
-				defs::update(S,border,x,previous_actions);
+				S.rem(x);
+				continue;
+			}
+			
+			f.extended = true;
+			f.x = x;
+			
+			previous_actions.push({defs::stop,0});
+			defs::update(S,border,x,previous_actions);
+			
+			if (defs::pool.n_idle() != 0)
+			{
+				unsigned oldest = top + 1;
+				forEachRemaining(id,S,border,previous_actions,frames.data(),top + 1,0,
+					[&](unsigned d, const Subtree&, const borderList&) { oldest = d; });
 				
-				if (defs::pool.n_idle() != 0)
-				{
-					defs::pool.push(branch,S,border,previous_actions);
-				}
-				else
+				// With no siblings left at any level, the child itself is split off.
+				if (oldest > top)
 				{
-					branch(id,S,border,previous_actions);
+					pushJob({ S, border });
+					
+					defs::restore(border,previous_actions);
+					S.rem(x);
+					continue;
 				}
 				
-				defs::restore(border,previous_actions);
+				forEachRemaining(id,S,border,previous_actions,frames.data(),top + 1,oldest,
+					[&](unsigned d, const Subtree& S, const borderList& border)
+				{
+					if (d == oldest) pushJob({ S, border, true });
+				});
+				frames[oldest].last = true;
+			}
+			
+			entering = true;
+			break;
+		}
+		
+		if (entering)
+		{
+			++top;
+			continue;
+		}
+		
+		defs::lists[id]->moveTo(S.numInduced,border);
+		
+		// No vertex on the border could be added, so this tree has
+		// no children and is a candidate itself.
+		if (!f.extended && S.numInduced > defs::largestTree)
+		{
+			defs::checkCandidate(S);
+		}
+		
+		if (top == 0) return;
+		
+		--top;
+		returning = true;
+	}
+}
+
+void pushJob(job j)
+{
+	++numTasks;
+	defs::pool.push([j = std::move(j)](int id) mutable
+	{
+		run(id,j);
+		--numTasks;
+	});
+}
+
+// Enumerates every tree whose smallest vertex is root, unless the
+// results cache shows that none of them can be the largest, or the
+// mask rules them all out.
+void branchFromRoot(int id, Graph::vertexID root)
+{
+	if (defs::rootBound(root) <= defs::largestTree) return;
+	
+	if (defs::forbidden[root]) return;
+	
+	// A tree rooted above a forced vertex cannot contain it.
+	for (Graph::vertexID x = 0; x < root; ++x)
+	{
+		if (defs::forced[x]) return;
+	}
+	
+	// Makes a subgraph with one vertex, its root.
+	job j { Subtree(root), {} };
+	
+	std::stack<defs::action> previous_actions;
+	
+	defs::update(j.S,j.border,root,previous_actions);
+	
+	run(id,j);
+}
+
+// Reads the jobs saved by another run into jobs. Returns false if the
+// file is missing, is for another lattice or other settings, or is malformed.
+bool loadCheckpoint(const std::string& filename, std::vector<job>& jobs)
+{
+	std::ifstream file(filename);
+	
+	std::string line;
+	std::getline(file, line);
+	
+	// The first line holds the dimensions, which must match the lattice.
+	std::vector<unsigned> dims;
+	std::stringstream header(line);
+	for (unsigned d; header >> d;) dims.push_back(d);
+	
+	if (!file || !std::equal(dims.begin(), dims.end(), Graph::dim_array.begin(), Graph::dim_array.end()))
+		return false;
+	
+	// The second line holds the settings, which must match this run's.
+	if (!std::getline(file, line) || line != searchSettings()) return false;
+	
+	while (std::getline(file, line))
+	{
+		std::stringstream fields(line);
+		
+		bool continued;
+		if (!(fields >> continued)) return false;
+		
+		StoredTree t(dims);
+		std::string item;
+		while (fields >> item && item != "|")
+		{
+			unsigned i = std::stoi(item);
+			if (i >= Graph::numVertices) return false;
+			t.add(i);
+		}
+		
+		auto S = defs::loadTree(t);
+		if (!S) return false;
+		
+		jobs.push_back({ *S, {}, continued });
+		
+		job& j = jobs.back();
+		for (unsigned i; fields >> i;)
+		{
+			if (i >= Graph::numVertices) return false;
+			j.border.push_back(Graph::vertexAt(i));
+		}
+	}
+	return true;
+}
+
+// Large-neighborhood search on defs::bestTree: repeatedly frees a random box
+// of the given side, and enumerates every way of filling it while the rest
+// of the lattice stays as it is. A larger tree found this way becomes
+// defs::bestTree, and later windows start from it.
+void improve(unsigned side, unsigned seconds)
+{
+	std::mt19937 rng(time(NULL));
+	
+	auto maskForbidden = defs::forbidden;
+	
+	uintmax_t numWindows = 0, numSplit = 0, numImproved = 0;
+	
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+	while (std::chrono::steady_clock::now() < deadline && !defs::stopRequested)
+	{
+		StoredTree best;
+		{
+			std::lock_guard<std::mutex> lock(defs::IOmutex);
+			best = defs::bestTree;
+		}
+		
+		std::array<unsigned, Graph::dim_array.size()> low;
+		for (unsigned d = 0; d < low.size(); ++d)
+		{
+			low[d] = rng() % (Graph::dim_array[d] - std::min(side, Graph::dim_array[d]) + 1);
+		}
+		
+		auto inWindow = [&](Graph::vertexID x)
+		{
+			for (unsigned d = 0; d < low.size(); ++d)
+			{
+				unsigned c = Graph::get_coord(d,x);
+				if (c < low[d] || c >= low[d] + side) return false;
+			}
+			return true;
+		};
+		
+		std::array<bool, Graph::numVertices> isFree;
+		for (Graph::vertexID x = 0; x < Graph::numVertices; ++x) isFree[x] = inWindow(x);
+		
+		// The tree outside the window may fall apart. Its largest piece stays
+		// as it is, and the other pieces are freed along with the window,
+		// unless they hold more vertices than the side of the window, since
+		// each freed vertex can double the work.
+		std::array<unsigned, Graph::numVertices> piece {};
+		std::vector<unsigned> pieceSize { 0 };
+		for (Graph::vertexID x = 0; x < Graph::numVertices; ++x)
+		{
+			if (!best.induced[Graph::position(x)] || isFree[x] || piece[x] != 0) continue;
+			
+			std::vector<Graph::vertexID> toBeVisited { x };
+			piece[x] = pieceSize.size();
+			pieceSize.push_back(0);
+			
+			while (!toBeVisited.empty())
+			{
+				Graph::vertexID y = toBeVisited.back();
+				toBeVisited.pop_back();
+				++pieceSize.back();
 				
-				S.rem(x);
+				for (Graph::vertexID z : Graph::vertices[y].neighbors)
+				{
+					if (best.induced[Graph::position(z)] && !isFree[z] && piece[z] == 0)
+					{
+						piece[z] = piece[x];
+						toBeVisited.push_back(z);
+					}
+				}
 			}
 		}
-		while (!border.empty());
 		
-		swap(border, defs::lists[id][S.numInduced]);
+		unsigned largest = std::max_element(pieceSize.begin(), pieceSize.end()) - pieceSize.begin();
+		unsigned numFreed = 0;
+		
+		StoredTree outside(best.dims);
+		for (Graph::vertexID x = 0; x < Graph::numVertices; ++x)
+		{
+			if (piece[x] == largest) outside.add(Graph::position(x));
+			else if (piece[x] != 0)
+			{
+				isFree[x] = true;
+				++numFreed;
+			}
+		}
+		
+		++numWindows;
+		
+		auto S = defs::loadTree(outside);
+		if (!S || numFreed > side)
+		{
+			++numSplit;
+			continue;
+		}
+		
+		for (Graph::vertexID x = 0; x < Graph::numVertices; ++x)
+		{
+			defs::forbidden[x] = maskForbidden[x] || !isFree[x];
+		}
+		
+		// Any free vertex may be added.
+		S->root = 0;
+		
+		indexedList<Graph::vertexID, Graph::numVertices> border;
+		for (Graph::vertexID x = 0; x < Graph::numVertices; ++x)
+		{
+			if (!S->has(x) && !defs::forbidden[x] && S->cnt(x) == 1 && S->safeToAdd(x))
+				border.push_back(x);
+		}
+		
+		unsigned before = defs::largestTree;
+		
+		pushJob({ *S, border });
+		while (numTasks != 0)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			if (defs::statusRequested) defs::printStatus();
+		}
+		
+		numImproved += defs::largestTree > before;
 	}
+	
+	defs::forbidden = maskForbidden;
+	
+	std::clog << numWindows << " windows, " << numSplit << " skipped for splitting the tree, "
+		<< numImproved << " improved it" << std::endl;
 }
 
 int main(int num_args, char** args)
 {
-	if (num_args != 2)
+	std::string improveFile, seedFile, checkpointFile, resumeFile;
+	unsigned window = 3, seconds = 60;
+	bool pin = false;
+	
+	bool valid = num_args >= 2;
+	for (int i = 2; i < num_args && valid; ++i)
+	{
+		std::string option = args[i];
+		
+		if (option == "--prune-enclosed") defs::pruneEnclosed = true;
+		else if (option == "--pin") pin = true;
+		else if (option == "--mask" && i + 1 < num_args) valid = defs::loadMask(args[++i]);
+		else if (option == "--seed-tree" && i + 1 < num_args) seedFile = args[++i];
+		else if (option == "--checkpoint" && i + 1 < num_args) checkpointFile = args[++i];
+		else if (option == "--resume" && i + 1 < num_args) resumeFile = args[++i];
+		else if (option == "--improve" && i + 1 < num_args) improveFile = args[++i];
+		else if (option == "--window" && i + 1 < num_args) window = std::stoi(args[++i]);
+		else if (option == "--seconds" && i + 1 < num_args) seconds = std::stoi(args[++i]);
+		else valid = false;
+	}
+	
+	if (!valid)
 	{
-		std::cerr << "usage: " << args[0] << " <outfile>" << std::endl;
+		std::cerr << "usage: " << args[0] << " <outfile> [--prune-enclosed] [--pin] [--mask FILE]"
+			" [--seed-tree FILE] [--checkpoint FILE] [--resume FILE]"
+			" [--improve FILE [--window SIDE] [--seconds T]]" << std::endl;
 		exit(1);
 	}
 	
 	defs::outfile = args[1];
 	
+	std::vector<job> resumed;
+	if (!resumeFile.empty() && !loadCheckpoint(resumeFile, resumed))
+	{
+		std::cerr << resumeFile << " is not a checkpoint for this lattice, mask and pruning" << std::endl;
+		exit(1);
+	}
+	
 	defs::start_time = clock();
 	
-	for (Graph::vertexID x = 0; x < Graph::numVertices; x++)
+	defs::installSignalHandlers();
+	
+	if (pin) defs::pinThreads();
+	
+	if (!improveFile.empty())
 	{
-		// Makes a subgraph with one vertex, its root.
-		Subtree S(x);
-		
-		indexedList<Graph::vertexID, Graph::numVertices> border;
+		// The start tree must be one the search could report, so it has no
+		// enclosed space and follows the mask.
+		if (!defs::seedFromTree(improveFile) || defs::largestTree == 0)
+		{
+			std::cerr << improveFile << " is not a valid tree for this lattice" << std::endl;
+			exit(1);
+		}
 		
-		std::stack<defs::action> previous_actions;
+		improve(window,seconds);
 		
-		defs::update(S,border,x,previous_actions);
+		std::clog << "Largest size = " << defs::largestTree << std::endl;
 		
-		defs::pool.push(branch,S,border,previous_actions);
+		defs::storeResult(false);
+		return 0;
 	}
 	
-	// Wait for all threads to finish
-	while (defs::pool.n_idle() < defs::NUM_THREADS)
+	if (defs::seedFromCache())
+	{
+		std::clog << "Largest size = " << defs::largestTree
+			<< " (already known)" << std::endl;
+		return 0;
+	}
+	
+	// Only larger trees are searched for, so a good seed prunes roots early.
+	if (!seedFile.empty() && !defs::seedFromTree(seedFile))
+	{
+		std::cerr << seedFile << " is not a valid tree for this lattice" << std::endl;
+		exit(1);
+	}
+	
+	// The best tree found before the checkpoint was written to the same file.
+	if (!resumeFile.empty()) defs::seedFromTree(defs::outfile);
+	
+	if (!checkpointFile.empty())
+	{
+		checkpoint.open(checkpointFile);
+		for (unsigned d : Graph::dim_array) checkpoint << d << ' ';
+		checkpoint << '\n' << searchSettings() << std::endl;
+	}
+	
+	if (!resumeFile.empty())
+	{
+		std::clog << "Resuming " << resumed.size() << " jobs" << std::endl;
+		for (job& j : resumed) pushJob(std::move(j));
+	}
+	else
+	{
+		for (Graph::vertexID x = 0; x < Graph::numVertices; x++)
+		{
+			++numTasks;
+			defs::pool.push([x](int id)
+			{
+				branchFromRoot(id,x);
+				--numTasks;
+			});
+		}
+	}
+	
+	// Wait for every job to finish. Idle threads alone do not show this,
+	// since a job may still be queued for them.
+	while (numTasks != 0)
 	{
 		std::this_thread::sleep_for (std::chrono::seconds(1));
 		
+		if (defs::statusRequested) defs::printStatus();
+		
 		std::lock_guard<std::mutex> lock(defs::IOmutex);
 		
 		std::clog << "\r" << defs::threadSeconds() << " thread-seconds elapsed" << std::flush;
@@ -94,5 +578,22 @@ int main(int num_args, char** args)
 		defs::lastWasNew = false;
 	}
 	
-	std::clog << std::endl << "Largest size = " << defs::largestTree << std::endl;
+	defs::pool.stop(true);
+	
+	uintmax_t numNodes = 0;
+	for (const defs::threadCount& c : defs::numNodes) numNodes += c.n;
+	
+	std::clog << std::endl << "Largest size = " << defs::largestTree
+		<< (defs::stopRequested ? " (stopped early)" : "") << std::endl;
+	std::clog << numNodes << " nodes searched" << std::endl;
+	
+	// A finished search leaves nothing to resume.
+	if (checkpoint.is_open())
+	{
+		checkpoint.close();
+		if (!defs::stopRequested) std::remove(checkpointFile.c_str());
+	}
+	
+	// A search that was stopped has only a lower bound.
+	defs::storeResult(!defs::stopRequested);
 }
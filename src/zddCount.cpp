@@ -0,0 +1,476 @@
+#include "frontier.hpp"
+
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <unordered_map>
+
+// Builds a zero-suppressed decision diagram (ZDD) of every induced subtree of
+// a lattice, by the frontier method: each node is a frontier (see
+// frontier.hpp) before deciding one vertex, with a lo edge for leaving the
+// vertex empty and a hi edge for inducing it. Frontiers that are equal share
+// a node, and after construction, nodes with the same children are merged
+// and nodes with no trees below them are dropped, bottom up. A closed tree
+// jumps straight to the 1 terminal, since every later vertex is empty.
+//
+// The diagram is used to count the trees of every size exactly, and to draw
+// trees uniformly at random, either from all trees or from the largest.
+
+using frontier::cell;
+
+// Counts can be far larger than 64 bits, even for small lattices.
+using count = unsigned __int128;
+
+// Terminal nodes. Any other child is an index into the next level.
+constexpr uint32_t ZERO = UINT32_MAX, ONE = UINT32_MAX - 1;
+
+// Runs f(begin, end) on each of numThreads contiguous blocks of [0, n).
+template<class F>
+void parallelFor(size_t n, unsigned numThreads, F f)
+{
+	std::vector<std::thread> threads;
+	for (unsigned t = 0; t < numThreads; ++t)
+	{
+		threads.emplace_back([&, t]() { f(n * t / numThreads, n * (t + 1) / numThreads); });
+	}
+	for (auto& t : threads) t.join();
+}
+
+std::string toString(count n)
+{
+	std::string s;
+	do
+	{
+		s += '0' + (unsigned)(n % 10);
+		n /= 10;
+	} while (n != 0);
+	
+	return { s.rbegin(), s.rend() };
+}
+
+class zdd
+{
+	public:
+	
+	struct node { uint32_t lo, hi; };
+	
+	// The nodes deciding each vertex. Level 0 has at most one node, the root.
+	std::vector<std::vector<node>> levels;
+	
+	// Builds the diagram for the lattice of rules, with one unique table
+	// per thread. Each frontier belongs to the table picked by its hash,
+	// and the frontiers of a level are numbered table by table.
+	zdd(const frontier::sweep& rules, unsigned numThreads)
+	{
+		const unsigned width = rules.width, n = rules.L.numVertices();
+		
+		std::vector<frontier::stateSet> current(numThreads, frontier::stateSet(width)), next = current;
+		std::vector<uint32_t> offsets(numThreads + 1, 1), nextOffsets(numThreads + 1);
+		std::vector<uint64_t> hashes;
+		std::vector<frontier::outcome> outcomes;
+		std::vector<uint32_t> index;
+		
+		current[0].insert(rules.start());
+		offsets[0] = 0;
+		
+		// The vertex being decided.
+		unsigned v = 0;
+		
+		auto frontierAt = [&](size_t i)
+		{
+			unsigned t = std::upper_bound(offsets.begin(), offsets.end(), i) - offsets.begin() - 1;
+			return current[t][i - offsets[t]];
+		};
+		
+		// Children are stepped once to find their table, then again by the
+		// thread that owns it, rather than keeping every child in memory.
+		auto child = [&](size_t k, std::span<cell> w)
+		{
+			std::ranges::copy(frontierAt(k / 2), w.begin());
+			
+			frontier::outcome o = rules.step(w, v, k % 2);
+			
+			if (o == frontier::open && v == n - 1)
+				o = frontier::sweep::isTree(w) ? frontier::closed : frontier::invalid;
+			
+			return o;
+		};
+		
+		for (; v < n; ++v)
+		{
+			const size_t numNodes = offsets.back();
+			
+			hashes.resize(2 * numNodes);
+			outcomes.resize(2 * numNodes);
+			index.resize(2 * numNodes);
+			
+			parallelFor(2 * numNodes, numThreads, [&](size_t begin, size_t end)
+			{
+				std::vector<cell> w(width);
+				for (size_t k = begin; k < end; ++k)
+				{
+					outcomes[k] = child(k, w);
+					if (outcomes[k] == frontier::open) hashes[k] = frontier::hash(w);
+				}
+			});
+			
+			parallelFor(numThreads, numThreads, [&](size_t t, size_t)
+			{
+				std::vector<cell> w(width);
+				next[t].clear();
+				for (size_t k = 0; k < 2 * numNodes; ++k)
+				{
+					if (outcomes[k] == frontier::open && (hashes[k] >> 48) % numThreads == t)
+					{
+						child(k, w);
+						index[k] = next[t].insert(w, hashes[k]).first;
+					}
+				}
+			});
+			
+			nextOffsets[0] = 0;
+			for (unsigned t = 0; t < numThreads; ++t)
+				nextOffsets[t+1] = nextOffsets[t] + next[t].size();
+			
+			levels.emplace_back(numNodes);
+			for (size_t i = 0; i < numNodes; ++i)
+			{
+				uint32_t edges[2];
+				for (bool add : { false, true })
+				{
+					size_t k = 2 * i + add;
+					
+					if (outcomes[k] == frontier::invalid)     edges[add] = ZERO;
+					else if (outcomes[k] == frontier::closed) edges[add] = ONE;
+					else edges[add] = nextOffsets[(hashes[k] >> 48) % numThreads] + index[k];
+				}
+				levels.back()[i] = { edges[0], edges[1] };
+			}
+			
+			std::swap(current, next);
+			std::swap(offsets, nextOffsets);
+			
+			unfolded += numNodes;
+			
+			std::clog << "\rvertex " << v + 1 << "/" << n << ", "
+				<< offsets.back() << " frontiers" << std::flush;
+		}
+		
+		std::clog << std::endl;
+		
+		reduce();
+	}
+	
+	// The number of nodes before and after merging.
+	size_t unfolded = 0;
+	
+	[[nodiscard]] size_t size() const
+	{
+		size_t sum = 0;
+		for (auto& level : levels) sum += level.size();
+		return sum;
+	}
+	
+	[[nodiscard]] uint32_t root() const { return levels[0].empty() ? ZERO : 0; }
+	
+	private:
+	
+	// Merges nodes with the same children and drops nodes with none, from
+	// the bottom up, so that each remaining node is distinct.
+	void reduce()
+	{
+		std::vector<uint32_t> below, here;
+		std::unordered_map<uint64_t, uint32_t> unique;
+		
+		auto remap = [&](uint32_t x) { return (x == ZERO || x == ONE) ? x : below[x]; };
+		
+		for (size_t v = levels.size(); v-- > 0;)
+		{
+			std::vector<node> merged;
+			here.assign(levels[v].size(), ZERO);
+			unique.clear();
+			
+			for (size_t i = 0; i < levels[v].size(); ++i)
+			{
+				node x = { remap(levels[v][i].lo), remap(levels[v][i].hi) };
+				if (x.lo == ZERO && x.hi == ZERO) continue;
+				
+				auto [it, inserted] = unique.try_emplace((uint64_t)x.lo << 32 | x.hi, merged.size());
+				if (inserted) merged.push_back(x);
+				here[i] = it->second;
+			}
+			
+			levels[v] = std::move(merged);
+			std::swap(below, here);
+		}
+	}
+};
+
+// The number of trees below each node of a zdd, by their number of vertices.
+// Only two levels are kept at once, unless every level is asked for, which
+// sampling needs.
+class sizeCounts
+{
+	public:
+	
+	// The counts for the nodes of one level. Node i has count[first[i] + j]
+	// trees of size lowest[i] + j, for j < first[i+1] - first[i].
+	struct level
+	{
+		std::vector<uint32_t> lowest;
+		std::vector<size_t> first;
+		std::vector<count> counts;
+		
+		[[nodiscard]] unsigned size(uint32_t i) const { return first[i+1] - first[i]; }
+		
+		// The number of trees of size s.
+		[[nodiscard]] count at(uint32_t i, unsigned s) const
+		{
+			return (s < lowest[i] || s >= lowest[i] + size(i)) ? 0 : counts[first[i] + s - lowest[i]];
+		}
+		
+		// The largest size with any trees, and how many there are.
+		[[nodiscard]] unsigned largest(uint32_t i) const { return lowest[i] + size(i) - 1; }
+		[[nodiscard]] count numLargest(uint32_t i) const { return counts[first[i+1] - 1]; }
+		
+		[[nodiscard]] count total(uint32_t i) const
+		{
+			count sum = 0;
+			for (size_t j = first[i]; j < first[i+1]; ++j) sum += counts[j];
+			return sum;
+		}
+	};
+	
+	std::vector<level> levels;
+	
+	// Set if any count does not fit in 128 bits.
+	bool overflow = false;
+	
+	sizeCounts(const zdd& z, unsigned numThreads, bool keepAll)
+	{
+		// The level past the last is left empty, since only terminals are there.
+		levels.resize(z.levels.size() + 1);
+		
+		std::atomic<bool> overflowed = false;
+		
+		for (size_t v = z.levels.size(); v-- > 0;)
+		{
+			const auto& nodes = z.levels[v];
+			const level& below = levels[v+1];
+			level& here = levels[v];
+			
+			auto child = [&](uint32_t x) -> std::pair<uint32_t, unsigned>
+			{
+				if (x == ZERO) return { 0, 0 };
+				if (x == ONE)  return { 0, 1 };
+				return { below.lowest[x], below.size(x) };
+			};
+			
+			here.lowest.resize(nodes.size());
+			here.first.assign(nodes.size() + 1, 0);
+			
+			for (size_t i = 0; i < nodes.size(); ++i)
+			{
+				auto [loLowest, loSize] = child(nodes[i].lo);
+				auto [hiLowest, hiSize] = child(nodes[i].hi);
+				++hiLowest;
+				
+				unsigned lowest = !loSize ? hiLowest : !hiSize ? loLowest : std::min(loLowest, hiLowest);
+				unsigned end = std::max(loSize ? loLowest + loSize : 0, hiSize ? hiLowest + hiSize : 0);
+				
+				here.lowest[i] = lowest;
+				here.first[i+1] = here.first[i] + end - lowest;
+			}
+			
+			here.counts.assign(here.first.back(), 0);
+			
+			auto at = [&](uint32_t x, unsigned s) -> count
+			{
+				if (x == ZERO) return 0;
+				if (x == ONE)  return s == 0;
+				return below.at(x,s);
+			};
+			
+			parallelFor(nodes.size(), numThreads, [&](size_t begin, size_t end)
+			{
+				bool failed = false;
+				for (size_t i = begin; i < end; ++i)
+				{
+					for (unsigned j = 0; j < here.size(i); ++j)
+					{
+						unsigned s = here.lowest[i] + j;
+						count hi = s ? at(nodes[i].hi, s - 1) : 0;
+						failed |= __builtin_add_overflow(at(nodes[i].lo, s), hi,
+							&here.counts[here.first[i] + j]);
+					}
+				}
+				if (failed) overflowed = true;
+			});
+			
+			if (!keepAll && v + 2 < levels.size()) levels[v+2] = level();
+		}
+		
+		overflow = overflowed;
+	}
+	
+	// The counts for each size over the whole lattice.
+	[[nodiscard]] std::vector<count> bySize(const zdd& z) const
+	{
+		std::vector<count> result;
+		if (z.root() == ZERO) return result;
+		
+		for (unsigned s = 0; s <= levels[0].largest(0); ++s) result.push_back(levels[0].at(0,s));
+		return result;
+	}
+};
+
+// Draws a tree uniformly at random, from all trees or only the largest.
+std::vector<char> sample(const zdd& z, const sizeCounts& counts, bool largest, std::mt19937_64& rng)
+{
+	std::vector<char> induced(z.levels.size(), false);
+	
+	// Returns a uniform random number below n.
+	auto below = [&](count n)
+	{
+		count threshold = -n % n, r;
+		do r = (count)rng() << 64 | rng(); while (r < threshold);
+		return r % n;
+	};
+	
+	uint32_t x = z.root();
+	for (size_t v = 0; x != ONE; ++v)
+	{
+		const auto& next = counts.levels[v+1];
+		const auto& n = z.levels[v][x];
+		
+		// The number of trees through a child, and their largest size.
+		auto weight = [&](uint32_t y, count& total, unsigned& size)
+		{
+			if (y == ZERO) { total = 0; size = 0; }
+			else if (y == ONE) { total = 1; size = 0; }
+			else
+			{
+				size  = next.largest(y);
+				total = largest ? next.numLargest(y) : next.total(y);
+			}
+		};
+		
+		count loWeight, hiWeight;
+		unsigned loSize, hiSize;
+		weight(n.lo, loWeight, loSize);
+		weight(n.hi, hiWeight, hiSize);
+		
+		// Only children that reach the largest size here count.
+		if (largest)
+		{
+			unsigned target = counts.levels[v].largest(x);
+			if (n.lo == ZERO || loSize != target)     loWeight = 0;
+			if (n.hi == ZERO || hiSize + 1 != target) hiWeight = 0;
+		}
+		
+		bool add = below(loWeight + hiWeight) >= loWeight;
+		induced[v] = add;
+		x = add ? n.hi : n.lo;
+	}
+	
+	return induced;
+}
+
+int main(int num_args, char** args)
+{
+	std::vector<std::string> options(args + 1, args + num_args);
+	
+	auto flag = [&](const std::string& name)
+	{
+		auto it = std::find(options.begin(), options.end(), name);
+		if (it == options.end()) return false;
+		options.erase(it);
+		return true;
+	};
+	
+	bool allowEnclosed = flag("--allow-enclosed"), largest = flag("--largest");
+	
+	unsigned numSamples = 0;
+	std::string sampleFile;
+	if (auto it = std::find(options.begin(), options.end(), "--sample");
+		it != options.end() && options.end() - it >= 3)
+	{
+		numSamples = std::stoi(it[1]);
+		sampleFile = it[2];
+		options.erase(it, it + 3);
+	}
+	
+	if (options.size() != 1)
+	{
+		std::cerr << "usage: " << args[0] << " <A,B,C,...> [--allow-enclosed]"
+			" [--sample <number> <outfile> [--largest]]" << std::endl;
+		exit(1);
+	}
+	
+	std::vector<unsigned> dims;
+	std::stringstream sizes(options[0]);
+	for (std::string d; std::getline(sizes, d, ',');) dims.push_back(std::stoi(d));
+	
+	if (dims.empty() || dims.size() > frontier::MAX_DIMENSIONS)
+	{
+		std::cerr << "between 1 and " << frontier::MAX_DIMENSIONS
+			<< " dimensions are supported" << std::endl;
+		exit(1);
+	}
+	
+	const frontier::orientation o(dims);
+	
+	if (o.swept.numVertices() / o.swept.dims.back() > frontier::MAX_WIDTH)
+	{
+		std::cerr << "the cross-section is too large, at most " << frontier::MAX_WIDTH
+			<< " vertices are supported" << std::endl;
+		exit(1);
+	}
+	
+	const unsigned numThreads = std::max(1u, std::thread::hardware_concurrency());
+	
+	const frontier::sweep rules(o.swept, allowEnclosed);
+	const zdd z(rules, numThreads);
+	
+	std::cout << z.size() << " nodes (" << z.unfolded << " before merging)" << std::endl;
+	
+	const sizeCounts counts(z, numThreads, numSamples != 0);
+	
+	if (counts.overflow)
+	{
+		std::cerr << "counts do not fit in 128 bits" << std::endl;
+		exit(1);
+	}
+	
+	count total = 0;
+	std::vector<count> bySize = counts.bySize(z);
+	for (unsigned s = 1; s < bySize.size(); ++s)
+	{
+		std::cout << s << " vertices: " << toString(bySize[s]) << " trees" << std::endl;
+		total += bySize[s];
+	}
+	
+	std::cout << "Total: " << toString(total) << " trees" << (allowEnclosed ? "" : " without enclosed space")
+		<< std::endl;
+	
+	if (bySize.empty()) return 0;
+	
+	std::cout << "Largest size = " << bySize.size() - 1 << std::endl;
+	
+	if (numSamples == 0) return 0;
+	
+	std::ofstream file(sampleFile);
+	std::mt19937_64 rng(time(NULL));
+	
+	for (unsigned i = 0; i < numSamples; ++i)
+	{
+		o.unsweep(sample(z, counts, largest, rng)).write(file);
+	}
+}